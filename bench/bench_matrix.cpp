@@ -0,0 +1,234 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Замеры производительности операций над векторами и матрицами
+//
+// bench_Matrix [--vector-sizes=1000,65536] [--matrix-sizes=64,256]
+//              [--types=float,double,int32,int64] [--min-time=0.2]
+//              [--json=результат.json]
+//
+// Для каждой операции печатается время одной итерации, GFLOP/s и GB/s
+// (объём - обязательные чтения и записи операндов); с --json те же
+// данные пишутся в файл для сравнения прогонов между версиями.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "tmatrix.h"
+
+namespace
+{
+  struct TOptions
+  {
+    std::vector<size_t> vectorSizes = { 1000, 65536, 4194304 };
+    std::vector<size_t> matrixSizes = { 64, 256, 1024 };
+    std::vector<std::string> types = { "float", "double", "int32", "int64" };
+    double minTime = 0.2;
+    std::string json;
+  };
+
+  // поток, отбрасывающий вывод: замер форматирования без записи в файл
+  class TNullBuffer : public std::streambuf
+  {
+  protected:
+    int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+  };
+
+  struct TResult
+  {
+    std::string op, type;
+    size_t n;
+    double seconds, gflops, gbytes;
+  };
+
+  volatile double sink;
+
+  template<typename T>
+  std::vector<T> split(const char* s, T (*conv)(const std::string&))
+  {
+    std::vector<T> res;
+    std::string item;
+    for (const char* p = s;; p++) {
+      if (*p == ',' || *p == '\0') {
+        if (!item.empty())
+          res.push_back(conv(item));
+        item.clear();
+        if (*p == '\0')
+          break;
+      }
+      else
+        item += *p;
+    }
+    return res;
+  }
+
+  size_t to_size(const std::string& s) { return size_t(std::strtoull(s.c_str(), nullptr, 10)); }
+  std::string to_string(const std::string& s) { return s; }
+
+  bool parse_options(int argc, char** argv, TOptions& opt)
+  {
+    for (int i = 1; i < argc; i++) {
+      const char* a = argv[i];
+      if (std::strncmp(a, "--vector-sizes=", 15) == 0)
+        opt.vectorSizes = split(a + 15, to_size);
+      else if (std::strncmp(a, "--matrix-sizes=", 15) == 0)
+        opt.matrixSizes = split(a + 15, to_size);
+      else if (std::strncmp(a, "--types=", 8) == 0)
+        opt.types = split(a + 8, to_string);
+      else if (std::strncmp(a, "--min-time=", 11) == 0)
+        opt.minTime = std::atof(a + 11);
+      else if (std::strncmp(a, "--json=", 7) == 0)
+        opt.json = a + 7;
+      else {
+        std::fprintf(stderr, "unknown option %s\n", a);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // среднее время одной итерации: повторяем f, пока суммарно не наберётся minTime
+  template<typename F>
+  double measure(double minTime, const F& f)
+  {
+    typedef std::chrono::steady_clock clock;
+    f(); // прогрев
+    size_t reps = 1;
+    for (;;) {
+      const clock::time_point start = clock::now();
+      for (size_t r = 0; r < reps; r++)
+        f();
+      const double t = std::chrono::duration<double>(clock::now() - start).count();
+      if (t >= minTime || reps >= (size_t(1) << 30))
+        return t / reps;
+      reps = t > 0 ? std::max(reps * 2, size_t(reps * minTime / t * 1.2)) : reps * 16;
+    }
+  }
+
+  template<typename T>
+  void fill(T* p, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      p[i] = T(i % 7 + 1);
+  }
+
+  class TBench
+  {
+    const TOptions& opt;
+    std::vector<TResult> results;
+
+    void report(const char* op, const char* type, size_t n, double sec, double flops, double bytes)
+    {
+      TResult r = { op, type, n, sec, flops / sec * 1e-9, bytes / sec * 1e-9 };
+      std::printf("%-13s %-7s %10zu %12.3f us %9.3f GFLOP/s %9.3f GB/s\n",
+        op, type, n, sec * 1e6, r.gflops, r.gbytes);
+      std::fflush(stdout);
+      results.push_back(r);
+    }
+
+  public:
+    explicit TBench(const TOptions& o) : opt(o) {}
+
+    template<typename T>
+    void vectors(const char* type)
+    {
+      const double s = sizeof(T);
+      for (size_t n : opt.vectorSizes) {
+        TDynamicVector<T> a(n), b(n), c(n);
+        fill(a.data(), n);
+        fill(b.data(), n);
+        const T k = T(3);
+        report("vec_add", type, n, measure(opt.minTime, [&] { c = a + b; }), n, 3 * n * s);
+        report("vec_sub", type, n, measure(opt.minTime, [&] { c = a - b; }), n, 3 * n * s);
+        report("vec_scale", type, n, measure(opt.minTime, [&] { c = a * k; }), n, 2 * n * s);
+        report("vec_dot", type, n, measure(opt.minTime, [&] { sink = double(a * b); }), 2.0 * n, 2 * n * s);
+        report("vec_axpy", type, n, measure(opt.minTime, [&] { c += a * k; }), 2.0 * n, 3 * n * s);
+        report("vec_fused", type, n, measure(opt.minTime, [&] { c = a + b - a * k; }), 3.0 * n, 3 * n * s);
+      }
+    }
+
+    template<typename T>
+    void matrices(const char* type)
+    {
+      const double s = sizeof(T);
+      for (size_t n : opt.matrixSizes) {
+        const double n2 = double(n) * n;
+        TDynamicMatrix<T> a(n), b(n), c(n);
+        TDynamicVector<T> x(n), y(n);
+        fill(a.data(), n * a.stride());
+        fill(b.data(), n * b.stride());
+        fill(x.data(), n);
+        const T k = T(3);
+        report("mat_add", type, n, measure(opt.minTime, [&] { c = a + b; }), n2, 3 * n2 * s);
+        report("mat_sub", type, n, measure(opt.minTime, [&] { c = a - b; }), n2, 3 * n2 * s);
+        report("mat_scale", type, n, measure(opt.minTime, [&] { c = a * k; }), n2, 2 * n2 * s);
+        report("mat_vec", type, n, measure(opt.minTime, [&] { y = a * x; }), 2 * n2, (n2 + 2.0 * n) * s);
+        report("vec_mat", type, n, measure(opt.minTime, [&] { y = x * a; }), 2 * n2, (n2 + 2.0 * n) * s);
+        report("mat_mul", type, n, measure(opt.minTime, [&] { c = a * b; }), 2 * n2 * n, 3 * n2 * s);
+        report("mat_transpose", type, n, measure(opt.minTime, [&] { c = transpose(a); }), 0, 2 * n2 * s);
+        TNullBuffer nullBuf;
+        std::ostream null(&nullBuf);
+        report("mat_print", type, n, measure(opt.minTime, [&] { null << a; }), 0, n2 * s);
+      }
+    }
+
+    void run()
+    {
+      for (const std::string& t : opt.types) {
+        if (t == "float") { vectors<float>("float"); matrices<float>("float"); }
+        else if (t == "double") { vectors<double>("double"); matrices<double>("double"); }
+        else if (t == "int32") { vectors<int32_t>("int32"); matrices<int32_t>("int32"); }
+        else if (t == "int64") { vectors<int64_t>("int64"); matrices<int64_t>("int64"); }
+        else
+          std::fprintf(stderr, "unknown type %s\n", t.c_str());
+      }
+    }
+
+    bool write_json(const std::string& path) const
+    {
+      std::ofstream out(path.c_str());
+      if (!out)
+        return false;
+      out << "{\n  \"simd\": \"" << tmatrix_detail::simd_level_name(tmatrix_detail::simd_level()) << "\",\n"
+          << "  \"threads\": " << TThreadPool::instance().num_threads() << ",\n"
+          << "  \"results\": [\n";
+      for (size_t i = 0; i < results.size(); i++) {
+        const TResult& r = results[i];
+        char line[256];
+        std::snprintf(line, sizeof(line),
+          "    {\"op\": \"%s\", \"type\": \"%s\", \"n\": %zu, \"seconds\": %.9g, \"gflops\": %.6g, \"gbytes\": %.6g}%s\n",
+          r.op.c_str(), r.type.c_str(), r.n, r.seconds, r.gflops, r.gbytes, i + 1 < results.size() ? "," : "");
+        out << line;
+      }
+      out << "  ]\n}\n";
+      return bool(out);
+    }
+  };
+}
+
+int main(int argc, char** argv)
+{
+  TOptions opt;
+  if (!parse_options(argc, argv, opt))
+    return 1;
+
+  std::printf("simd: %s, threads: %zu\n",
+    tmatrix_detail::simd_level_name(tmatrix_detail::simd_level()), TThreadPool::instance().num_threads());
+  TBench bench(opt);
+  bench.run();
+
+  if (!opt.json.empty() && !bench.write_json(opt.json)) {
+    std::fprintf(stderr, "cannot write %s\n", opt.json.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -8,295 +8,1094 @@
 #define __TDynamicMatrix_H__
 
 #include <iostream>
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <type_traits>
+
+#include "tmatrix_memory.h"
+#include "tmatrix_gemm.h"
+#include "tmatrix_kernels.h"
+#include "tmatrix_transpose.h"
+#include "tmatrix_charconv.h"
+#include "tmatrix_expr.h"
 
 using namespace std;
 
 const int MAX_VECTOR_SIZE = 100000000;
-const int MAX_MATRIX_SIZE = 10000;
+// ограничение матрицы - по общему числу элементов, поэтому допустимы
+// и узкие высокие матрицы (например, 10000000 x 64);
+// MAX_MATRIX_SIZE - наибольшая сторона квадратной матрицы
+const size_t MAX_MATRIX_ELEMENTS = size_t(1) << 31;
+const int MAX_MATRIX_SIZE = 46340;
+
+// operator[] не проверяет индекс (в отладочной сборке - только assert),
+// как у стандартных контейнеров; at() проверяет всегда.
+// С TMATRIX_CHECKED_INDEX (опция CMake) operator[] тоже бросает out_of_range
+#ifdef TMATRIX_CHECKED_INDEX
+#define TMATRIX_CHECK_INDEX(ind, sz, msg) do { if ((ind) >= (sz)) throw out_of_range(msg); } while (0)
+#else
+#define TMATRIX_CHECK_INDEX(ind, sz, msg) assert((ind) < (sz) && msg)
+#endif
 
 // Динамический вектор - 
-// шаблонный вектор на динамической памяти
-template<typename T>
-class TDynamicVector
+// шаблонный вектор на динамической памяти.
+// Память берётся у распределителя Alloc (по умолчанию -
+// TAlignedAllocator<T>, буфер выровнен на 64 байта).
+// Арифметика строит шаблоны выражений (tmatrix_expr.h), которые
+// вычисляются за один проход при присваивании или конструировании
+template<typename T, typename Alloc>
+class TDynamicVector : public TVecExpr<TDynamicVector<T, Alloc>>
 {
+  typedef std::allocator_traits<Alloc> alloc_traits;
+
+  static size_t checked_size(size_t size)
+  {
+    if ((size <= 0) || (size > MAX_VECTOR_SIZE))
+      throw out_of_range("Vector size should be greater than zero");
+    return size;
+  }
 protected:
   size_t sz;
   T* pMem;
+  Alloc alloc;
+  tmatrix_detail::TBufferOwner<T>* owner = nullptr; // не nullptr - буфер чужой
+
+  // свой буфер возвращается распределителю, чужой - своему владельцу
+  void release_buffer() noexcept
+  {
+      if (owner != nullptr) {
+          owner->release(pMem);
+          delete owner;
+          owner = nullptr;
+      }
+      else
+          tmatrix_detail::free_array(alloc, pMem, sz);
+  }
 public:
-  TDynamicVector(size_t size = 1) : sz(size)
+  typedef T value_type;
+  typedef Alloc allocator_type;
+
+  TDynamicVector(size_t size = 1, const Alloc& a = Alloc()) : sz(checked_size(size)), alloc(a)
   {
-    if ((sz <= 0)||(sz>MAX_VECTOR_SIZE))
-      throw out_of_range("Vector size should be greater than zero");
-    pMem = new T[sz];// {}; // У типа T д.б. констуктор по умолчанию
+    pMem = tmatrix_detail::allocate_array(alloc, sz); // У типа T д.б. констуктор по умолчанию
+  }
+  // без заполнения, с нулями или с заданным значением (см. tmatrix_memory.h)
+  TDynamicVector(size_t size, TUninitializedInit tag, const Alloc& a = Alloc()) : sz(checked_size(size)), alloc(a)
+  {
+    pMem = tmatrix_detail::allocate_array(alloc, sz, tag);
   }
-  TDynamicVector(T* arr, size_t s) : sz(s)
+  TDynamicVector(size_t size, TZeroInit tag, const Alloc& a = Alloc()) : sz(checked_size(size)), alloc(a)
+  {
+    pMem = tmatrix_detail::allocate_array(alloc, sz, tag);
+  }
+  TDynamicVector(size_t size, TFillInit tag, const T& val, const Alloc& a = Alloc()) : sz(checked_size(size)), alloc(a)
+  {
+    pMem = tmatrix_detail::allocate_array(alloc, sz, tag, val);
+  }
+  TDynamicVector(T* arr, size_t s, const Alloc& a = Alloc()) : sz(s), alloc(a)
   {
     assert(arr != nullptr && "TDynamicVector ctor requires non-nullptr arg");
-    pMem = new T[sz];
+    pMem = tmatrix_detail::allocate_array(alloc, sz);
     std::copy(arr, arr + sz, pMem);
   }
+  // без копирования: вектор владеет arr и освобождает его вызовом deleter(arr)
+  template<typename Deleter>
+  TDynamicVector(TAdoptBuffer, T* arr, size_t s, Deleter deleter, const Alloc& a = Alloc())
+    : sz(s), pMem(arr), alloc(a)
+  {
+    owner = tmatrix_detail::adopt(arr, std::move(deleter));
+    if (arr == nullptr || sz == 0 || sz > MAX_VECTOR_SIZE) {
+      release_buffer();
+      throw out_of_range("Vector size should be greater than zero");
+    }
+  }
   TDynamicVector(const TDynamicVector& v)
+    : sz(v.sz), alloc(alloc_traits::select_on_container_copy_construction(v.alloc))
   {
-      sz = v.sz;
-      pMem = new T[sz];
-      for (int i = 0; i < sz; i++)
-          pMem[i] = v.pMem[i];
+      pMem = tmatrix_detail::allocate_array(alloc, sz);
+      std::copy(v.pMem, v.pMem + sz, pMem);
   }
-  TDynamicVector(TDynamicVector&& v) noexcept
+  template<typename E>
+  TDynamicVector(const TVecExpr<E>& e, const Alloc& a = Alloc()) : TDynamicVector(e.self().size(), a)
   {
-      pMem = nullptr;
-      swap(*this, v);
+      tmatrix_detail::expr_assign(pMem, e.self());
+  }
+  TDynamicVector(TDynamicVector&& v) noexcept : sz(0), pMem(nullptr), alloc(std::move(v.alloc))
+  {
+      swap_storage(v);
   }
   ~TDynamicVector()
   {
-      delete[]pMem;
+      release_buffer();
   }
   TDynamicVector& operator=(const TDynamicVector& v)
   {
       if (this != &v) {
-          sz = v.sz;
-          delete[] pMem;
-          pMem = new T[sz];
-          for (int i = 0; i < sz; i++) {
-              pMem[i] = v.pMem[i];
+          const bool propagate = alloc_traits::propagate_on_container_copy_assignment::value && (alloc != v.alloc);
+          if ((sz != v.sz) || propagate) {
+              Alloc a = propagate ? v.alloc : alloc;
+              T* p = tmatrix_detail::allocate_array(a, v.sz);
+              release_buffer();
+              alloc = a;
+              pMem = p;
+              sz = v.sz;
           }
+          std::copy(v.pMem, v.pMem + sz, pMem);
       }
       return *this;
-}
-  TDynamicVector& operator=(TDynamicVector&& v) noexcept
+  }
+  // буфер забирается, если распределитель переходит вместе с ним,
+  // распределители равны или оба буфера чужие; иначе элементы копируются
+  TDynamicVector& operator=(TDynamicVector&& v)
+    noexcept(alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value)
+  {
+      if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+          using std::swap;
+          swap(alloc, v.alloc);
+      }
+      else if ((alloc != v.alloc) && ((owner == nullptr) || (v.owner == nullptr)))
+          return *this = static_cast<const TDynamicVector&>(v);
+      swap_storage(v);
+      return *this;
+  }
+  // выражение может ссылаться на этот же вектор: при смене размера или
+  // непоэлементном чтении приёмника результат строится в новом буфере
+  template<typename E>
+  TDynamicVector& operator=(const TVecExpr<E>& e)
   {
-      swap(*this, v);
+      if ((sz != e.self().size()) || e.self().aliases(pMem, sz * sizeof(T))) {
+          TDynamicVector tmp(e, alloc);
+          swap(*this, tmp);
+      }
+      else
+          tmatrix_detail::expr_assign(pMem, e.self());
       return *this;
   }
 
+  allocator_type get_allocator() const { return alloc; }
   size_t size() const noexcept { return sz; }
+  T* data() noexcept { return pMem; }
+  const T* data() const noexcept { return pMem; }
+  const T& eval(size_t ind) const noexcept { return pMem[ind]; }
+  bool aliases(const void*, size_t) const noexcept { return false; }
 
   // индексация
   T& operator[](size_t ind)
   {
-      if ((ind >= sz) || (ind < 0))
-          throw out_of_range("index of element is more than a len of vector");
+      TMATRIX_CHECK_INDEX(ind, sz, "index of element is more than a len of vector");
       return pMem[ind];
   }
   const T& operator[](size_t ind) const
   {
-      if ((ind >= sz) || (ind < 0))
-          throw out_of_range("index of element is more than a len of vector");
+      TMATRIX_CHECK_INDEX(ind, sz, "index of element is more than a len of vector");
       return pMem[ind];
   }
   // индексация с контролем
   T& at(size_t ind)
   {
-      if ((ind >= sz) || (ind < 0))
+      if (ind >= sz)
           throw out_of_range("index of element is more than a len of vector");
       return pMem[ind];
   }
   const T& at(size_t ind) const
   {
-      if ((ind >= sz) || (ind < 0))
+      if (ind >= sz)
           throw out_of_range("index of element is more than a len of vector");
       return pMem[ind];
   }
 
-  // сравнение
-  bool operator==(const TDynamicVector& v) const 
+  // составное присваивание - результат пишется прямо в pMem
+  template<typename E>
+  TDynamicVector& operator+=(const TVecExpr<E>& e)
+  {
+      if (sz != e.self().size())
+          throw invalid_argument("the length of the vectors must be the same");
+      if (e.self().aliases(pMem, sz * sizeof(T)))
+          return *this += TDynamicVector(e, alloc);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpAdd>(pMem, e.self());
+      return *this;
+  }
+  template<typename E>
+  TDynamicVector& operator-=(const TVecExpr<E>& e)
   {
-      if (sz == v.sz)
-          for (int i = 0; i < sz; i++)
-              if (pMem[i] != v.pMem[i])
-                  return false;
-      if (sz != v.sz)
-          return false;
-      return true;
+      if (sz != e.self().size())
+          throw invalid_argument("the length of the vectors must be the same");
+      if (e.self().aliases(pMem, sz * sizeof(T)))
+          return *this -= TDynamicVector(e, alloc);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpSub>(pMem, e.self());
+      return *this;
   }
-  bool operator!=(const TDynamicVector& v) const 
+  TDynamicVector& operator+=(const T& val)
   {
-      return !(v==*this);
+      for (size_t i = 0; i < sz; i++)
+          pMem[i] += val;
+      return *this;
+  }
+  TDynamicVector& operator-=(const T& val)
+  {
+      for (size_t i = 0; i < sz; i++)
+          pMem[i] -= val;
+      return *this;
+  }
+  TDynamicVector& operator*=(const T& val)
+  {
+      tmatrix_detail::vec_scale(pMem, val, pMem, sz);
+      return *this;
+  }
+
+  // распределители обмениваются, только если это разрешено
+  // propagate_on_container_swap (иначе они должны быть равны)
+  friend void swap(TDynamicVector& lhs, TDynamicVector& rhs) noexcept
+  {
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      using std::swap;
+      swap(lhs.alloc, rhs.alloc);
+    }
+    lhs.swap_storage(rhs);
   }
 
-  // скалярные операции
-  TDynamicVector operator+(T val)
+private:
+  void swap_storage(TDynamicVector& v) noexcept
   {
-      TDynamicVector tmp(sz);
-      for (int i = 0; i < tmp.sz; i++)
-          tmp.pMem[i] = pMem[i] + val;
-      return tmp;
+    std::swap(sz, v.sz);
+    std::swap(pMem, v.pMem);
+    std::swap(owner, v.owner);
   }
-  TDynamicVector operator-(T val)
+public:
+
+  // ввод/вывод
+  // числа разбираются from_chars прямо из буфера потока и пишутся
+  // to_chars через буфер (tmatrix_charconv.h)
+  friend istream& operator>>(istream& istr, TDynamicVector& v)
   {
-      TDynamicVector tmp(sz);
-      for (int i = 0; i < tmp.sz; i++)
-          tmp.pMem[i] = pMem[i] - val;
-      return tmp;
+    tmatrix_detail::read_values(istr, v.pMem, v.sz);
+    return istr;
   }
-  TDynamicVector operator*(T val)
+  friend ostream& operator<<(ostream& ostr, const TDynamicVector& v)
   {
-      TDynamicVector tmp(sz);
-      for (int i = 0; i < tmp.sz; i++)
-          tmp.pMem[i] = pMem[i] * val;
-      return tmp;
+    tmatrix_detail::write_values(ostr, v.pMem, v.sz);
+    return ostr;
   }
+};
+
+
+
+
+// Представление вектора -
+// невладеющая ссылка на непрерывный участок чужой памяти (строку матрицы,
+// буфер другой библиотеки, отображённый файл); память не копируется и
+// должна жить дольше представления
+template<typename T>
+class TVectorView : public TVecExpr<TVectorView<T>>
+{
+protected:
+  size_t sz;
+  T* pMem;
+public:
+  typedef typename remove_const<T>::type value_type;
+
+  TVectorView(T* p, size_t size) : sz(size), pMem(p) {}
+  template<typename A>
+  TVectorView(TDynamicVector<value_type, A>& v) : sz(v.size()), pMem(v.data()) {}
+  template<typename A, typename U = T, typename = enable_if_t<is_const<U>::value>>
+  TVectorView(const TDynamicVector<value_type, A>& v) : sz(v.size()), pMem(v.data()) {}
+
+  operator TVectorView<const T>() const noexcept { return TVectorView<const T>(pMem, sz); }
 
-  // векторные операции
-  TDynamicVector operator+(const TDynamicVector& v)
+  size_t size() const noexcept { return sz; }
+  T* data() const noexcept { return pMem; }
+  const T& eval(size_t ind) const noexcept { return pMem[ind]; }
+  bool aliases(const void* p, size_t bytes) const noexcept
   {
-      if (sz != v.sz)
-          throw exception("the length of the vectors must be the same");
-      TDynamicVector tmp(sz);;
-      for (int i = 0; i < tmp.sz; i++)
-          tmp.pMem[i] = pMem[i] + v.pMem[i];
-      return tmp;
+      return tmatrix_detail::view_aliases(p, bytes, pMem, sz * sizeof(T), sz * sizeof(T));
   }
-  TDynamicVector operator-(const TDynamicVector& v)
+
+  // индексация
+  T& operator[](size_t ind) const
   {
-      if (sz != v.sz)
-          throw exception("the length of the vectors must be the same");
-      TDynamicVector tmp(sz);
-      for (int i = 0; i < tmp.sz; i++)
-          tmp.pMem[i] = pMem[i] - v.pMem[i];
-      return tmp;
+      TMATRIX_CHECK_INDEX(ind, sz, "index of element is more than a len of vector");
+      return pMem[ind];
   }
-  T operator*(const TDynamicVector& v) 
+  // индексация с контролем
+  T& at(size_t ind) const
   {
-      if (sz != v.sz)
-          throw exception("the length of the vectors must be the same");
-      T tmp=0;
-      for (int i = 0; i < sz; i++)
-          tmp += pMem[i] * v.pMem[i];
-      return tmp;
+      if (ind >= sz)
+          throw out_of_range("index of element is more than a len of vector");
+      return pMem[ind];
   }
 
-  friend void swap(TDynamicVector& lhs, TDynamicVector& rhs) noexcept
+  // поэлементное копирование в представляемую память (размер не меняется)
+  template<typename E>
+  const TVectorView& operator=(const TVecExpr<E>& e) const
+  {
+      if (sz != e.self().size())
+          throw invalid_argument("the length of the vectors must be the same");
+      if (e.self().aliases(pMem, sz * sizeof(T)))
+          return *this = TDynamicVector<value_type>(e);
+      tmatrix_detail::expr_assign(pMem, e.self());
+      return *this;
+  }
+  // копия ссылается на ту же память, присваивание копирует элементы
+  TVectorView(const TVectorView&) = default;
+  const TVectorView& operator=(const TVectorView& v) const
+  {
+      return *this = static_cast<const TVecExpr<TVectorView>&>(v);
+  }
+
+  // составное присваивание
+  template<typename E>
+  const TVectorView& operator+=(const TVecExpr<E>& e) const
+  {
+      if (sz != e.self().size())
+          throw invalid_argument("the length of the vectors must be the same");
+      if (e.self().aliases(pMem, sz * sizeof(T)))
+          return *this += TDynamicVector<value_type>(e);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpAdd>(pMem, e.self());
+      return *this;
+  }
+  template<typename E>
+  const TVectorView& operator-=(const TVecExpr<E>& e) const
   {
-    std::swap(lhs.sz, rhs.sz);
-    std::swap(lhs.pMem, rhs.pMem);
+      if (sz != e.self().size())
+          throw invalid_argument("the length of the vectors must be the same");
+      if (e.self().aliases(pMem, sz * sizeof(T)))
+          return *this -= TDynamicVector<value_type>(e);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpSub>(pMem, e.self());
+      return *this;
+  }
+  const TVectorView& operator*=(const value_type& val) const
+  {
+      tmatrix_detail::vec_scale(pMem, val, pMem, sz);
+      return *this;
   }
 
   // ввод/вывод
-  friend istream& operator>>(istream& istr, TDynamicVector& v)
+  friend istream& operator>>(istream& istr, TVectorView v)
   {
-    for (size_t i = 0; i < v.sz; i++)
-      istr >> v.pMem[i]; // требуется оператор>> для типа T
+    tmatrix_detail::read_values(istr, v.pMem, v.sz);
     return istr;
   }
-  friend ostream& operator<<(ostream& ostr, const TDynamicVector& v)
+  friend ostream& operator<<(ostream& ostr, const TVectorView& v)
   {
-    for (size_t i = 0; i < v.sz; i++)
-      ostr << v.pMem[i] << ' '; // требуется оператор<< для типа T
+    tmatrix_detail::write_values(ostr, v.pMem, v.sz);
     return ostr;
   }
 };
 
 
-// Динамическая матрица - 
-// шаблонная матрица на динамической памяти
+// Представление вектора с шагом -
+// size элементов чужой памяти через inc элементов: столбец матрицы (шаг -
+// stride() матрицы), её диагональ (stride() + 1). Как и TVectorView,
+// участвует в векторных операциях без копирования
 template<typename T>
-class TDynamicMatrix : public TDynamicVector<TDynamicVector<T>>
+class TStridedVectorView : public TVecExpr<TStridedVectorView<T>>
 {
-  using TDynamicVector<TDynamicVector<T>>::pMem;
-  using TDynamicVector<TDynamicVector<T>>::sz;
+protected:
+  size_t sz, inc;
+  T* pMem;
+
+  // байты от первого до последнего элемента (для проверки наложения)
+  size_t span_bytes() const noexcept { return sz == 0 ? 0 : ((sz - 1) * inc + 1) * sizeof(T); }
 public:
-  TDynamicMatrix(size_t s = 1) : TDynamicVector<TDynamicVector<T>>(s)
+  typedef typename remove_const<T>::type value_type;
+
+  TStridedVectorView(T* p, size_t size, size_t step) : sz(size), inc(step), pMem(p) {}
+
+  operator TStridedVectorView<const T>() const noexcept { return TStridedVectorView<const T>(pMem, sz, inc); }
+
+  size_t size() const noexcept { return sz; }
+  // расстояние между соседними элементами
+  size_t stride() const noexcept { return inc; }
+  T* data() const noexcept { return pMem; }
+  const T& eval(size_t ind) const noexcept { return pMem[ind * inc]; }
+  bool aliases(const void* p, size_t bytes) const noexcept
   {
-    if ((s <= 0) || (s > MAX_MATRIX_SIZE))
-        throw out_of_range("matrix size should be greater than zero");
-    for (size_t i = 0; i < sz; i++)
-        pMem[i] = TDynamicVector<T>(sz);
+      return tmatrix_detail::view_aliases(p, bytes, pMem, span_bytes(), span_bytes());
   }
 
-  using TDynamicVector<TDynamicVector<T>>::operator[];
+  // индексация
+  T& operator[](size_t ind) const
+  {
+      TMATRIX_CHECK_INDEX(ind, sz, "index of element is more than a len of vector");
+      return pMem[ind * inc];
+  }
+  // индексация с контролем
+  T& at(size_t ind) const
+  {
+      if (ind >= sz)
+          throw out_of_range("index of element is more than a len of vector");
+      return pMem[ind * inc];
+  }
 
-  // сравнение
-  bool operator==(const TDynamicMatrix& m) const 
+  // поэлементное копирование в представляемую память (размер не меняется)
+  template<typename E>
+  const TStridedVectorView& operator=(const TVecExpr<E>& e) const
+  {
+      return update(e, [](T& x, const value_type& y) { x = y; });
+  }
+  // копия ссылается на ту же память, присваивание копирует элементы
+  TStridedVectorView(const TStridedVectorView&) = default;
+  const TStridedVectorView& operator=(const TStridedVectorView& v) const
   {
-      if (sz == m.sz)
-          for (int i = 0; i < sz; i++)
-              if (pMem[i] != m.pMem[i])
-                  return false;
-      if (sz!=m.sz)
-          return false;
-      return true;
+      return *this = static_cast<const TVecExpr<TStridedVectorView>&>(v);
   }
 
-  // матрично-скалярные операции
-  TDynamicMatrix operator*(const T& val)
+  // составное присваивание
+  template<typename E>
+  const TStridedVectorView& operator+=(const TVecExpr<E>& e) const
   {
-      TDynamicMatrix<T> tmp(sz);
-      for (int i = 0; i < sz; i++) {
-          tmp.pMem[i] = pMem[i] * val;
-      }
-      return tmp;
+      return update(e, [](T& x, const value_type& y) { x += y; });
+  }
+  template<typename E>
+  const TStridedVectorView& operator-=(const TVecExpr<E>& e) const
+  {
+      return update(e, [](T& x, const value_type& y) { x -= y; });
+  }
+  const TStridedVectorView& operator*=(const value_type& val) const
+  {
+      for (size_t i = 0; i < sz; i++)
+          pMem[i * inc] *= val;
+      return *this;
   }
-  
 
-  // матрично-векторные операции
-  TDynamicVector<T> operator*(const TDynamicVector<T>& v)
+private:
+  template<typename E, typename Op>
+  const TStridedVectorView& update(const TVecExpr<E>& expr, Op op) const
   {
-      if (sz != v.sz) {
-          throw exception("matrix's sizes should be the same");
+      const E& e = expr.self();
+      if (sz != e.size())
+          throw invalid_argument("the length of the vectors must be the same");
+      if (e.aliases(pMem, span_bytes())) {
+          TDynamicVector<value_type> tmp(e);
+          for (size_t i = 0; i < sz; i++)
+              op(pMem[i * inc], tmp[i]);
       }
+      else
+          for (size_t i = 0; i < sz; i++)
+              op(pMem[i * inc], e.eval(i));
+      return *this;
+  }
+public:
 
-      TDynamicVector<T> tmp(sz);
+  // ввод/вывод
+  friend istream& operator>>(istream& istr, TStridedVectorView v)
+  {
+    tmatrix_detail::read_values(istr, v.pMem, v.sz, v.inc);
+    return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TStridedVectorView& v)
+  {
+    tmatrix_detail::write_values(ostr, v.pMem, v.sz, v.inc);
+    return ostr;
+  }
+};
 
-      for (int i = 0; i < sz; i++) {
-          T sum = 0;
-          for (int j = 0; i < sz; i++) {
-              sum += pMem[i][j] * v[j]
-          }
 
-          tmp[i] = sum;
-      }
+// Динамическая матрица - 
+// шаблонная матрица rows x cols на динамической памяти.
+// Все элементы лежат в одном буфере от распределителя Alloc (по умолчанию
+// выровненном на 64 байта) построчно с шагом stride() >= cols() (длинные
+// строки дополняются до целого числа строк кэша, см. row_stride),
+// operator[] возвращает представление строки без копирования
+template<typename T, typename Alloc>
+class TDynamicMatrix : public TMatExpr<TDynamicMatrix<T, Alloc>>
+{
+  typedef std::allocator_traits<Alloc> alloc_traits;
+
+  // шаг строки для rows x cols с проверкой ограничения на число элементов
+  static size_t checked_stride(size_t rows, size_t cols)
+  {
+    if ((rows == 0) || (cols == 0))
+        throw out_of_range("matrix size should be greater than zero");
+    if (cols > MAX_MATRIX_ELEMENTS / rows)
+        throw out_of_range("matrix has too many elements");
+    return tmatrix_detail::row_stride<T>(cols);
+  }
+protected:
+  size_t nRows, nCols, ld;
+  T* pMem;
+  Alloc alloc;
+  tmatrix_detail::TBufferOwner<T>* owner = nullptr; // не nullptr - буфер чужой
 
-      return tmp;
+  void release_buffer() noexcept
+  {
+      if (owner != nullptr) {
+          owner->release(pMem);
+          delete owner;
+          owner = nullptr;
+      }
+      else
+          tmatrix_detail::free_array(alloc, pMem, nRows * ld);
   }
+public:
+  typedef T value_type;
+  typedef Alloc allocator_type;
 
-  // матрично-матричные операции
-  TDynamicMatrix operator+(const TDynamicMatrix& m)
+  TDynamicMatrix(size_t s = 1, const Alloc& a = Alloc()) : TDynamicMatrix(s, s, a) {}
+  TDynamicMatrix(size_t rows, size_t cols, const Alloc& a = Alloc())
+    : nRows(rows), nCols(cols), ld(checked_stride(rows, cols)), alloc(a)
+  {
+    pMem = tmatrix_detail::allocate_array(alloc, nRows * ld);
+  }
+  // без заполнения, с нулями или с заданным значением (см. tmatrix_memory.h);
+  // значение записывается и в дополнение строк
+  TDynamicMatrix(size_t rows, size_t cols, TUninitializedInit tag, const Alloc& a = Alloc())
+    : nRows(rows), nCols(cols), ld(checked_stride(rows, cols)), alloc(a)
   {
-      if (sz != m.sz) 
-          throw exception("matrix's sizes should be the same");
-      TDynamicMatrix<T> tmp(sz);
-      for (int i = 0; i < sz; i++)
-          tmp.pMem[i] = pMem[i] + m.pMem[i];
-      return tmp;
+    pMem = tmatrix_detail::allocate_array(alloc, nRows * ld, tag);
   }
-  TDynamicMatrix operator-(const TDynamicMatrix& m)
+  TDynamicMatrix(size_t rows, size_t cols, TZeroInit tag, const Alloc& a = Alloc())
+    : nRows(rows), nCols(cols), ld(checked_stride(rows, cols)), alloc(a)
   {
-      if (sz != m.sz)
-          throw exception("matrix's sizes should be the same");
-      TDynamicMatrix<T> tmp(sz);
-      for (int i = 0; i < sz; i++)
-          tmp.pMem[i] = pMem[i] - m.pMem[i];
-      return tmp;
+    pMem = tmatrix_detail::allocate_array(alloc, nRows * ld, tag);
   }
-  TDynamicMatrix operator*(const TDynamicMatrix& m)
+  TDynamicMatrix(size_t rows, size_t cols, TFillInit tag, const T& val, const Alloc& a = Alloc())
+    : nRows(rows), nCols(cols), ld(checked_stride(rows, cols)), alloc(a)
   {
-      if (sz != v.sz)
-          throw exception("matrix's sizes should be the same");
-      TDynamicMatrix<T> tmp(sz);
-      for (int i = 0; i < sz; i++) {
-          for (int j = 0; j < sz; j++) {
-              T sum = 0;
-              for (int k = 0; k < sz; k++) {
-                  sum += pMem[i][k] * m[k][j];
-              }
-              tmp[i][j] = sum;
+    pMem = tmatrix_detail::allocate_array(alloc, nRows * ld, tag, val);
+  }
+  // без копирования: матрица владеет буфером p (rows x cols построчно, без
+  // дополнения строк) и освобождает его вызовом deleter(p)
+  template<typename Deleter>
+  TDynamicMatrix(TAdoptBuffer, T* p, size_t rows, size_t cols, Deleter deleter, const Alloc& a = Alloc())
+    : nRows(rows), nCols(cols), ld(cols), pMem(p), alloc(a)
+  {
+    owner = tmatrix_detail::adopt(p, std::move(deleter));
+    try {
+      checked_stride(rows, cols);
+    }
+    catch (...) {
+      release_buffer();
+      throw;
+    }
+  }
+  TDynamicMatrix(const TDynamicMatrix& m) : nRows(m.nRows), nCols(m.nCols), ld(m.ld),
+    alloc(alloc_traits::select_on_container_copy_construction(m.alloc))
+  {
+      pMem = tmatrix_detail::allocate_array(alloc, nRows * ld);
+      copy(m.pMem, m.pMem + nRows * ld, pMem);
+  }
+  template<typename E>
+  TDynamicMatrix(const TMatExpr<E>& e, const Alloc& a = Alloc()) : TDynamicMatrix(e.self().rows(), e.self().cols(), a)
+  {
+      tmatrix_detail::expr_assign(pMem, ld, e.self());
+  }
+  TDynamicMatrix(TDynamicMatrix&& m) noexcept : nRows(0), nCols(0), ld(0), pMem(nullptr), alloc(std::move(m.alloc))
+  {
+      swap_storage(m);
+  }
+  ~TDynamicMatrix()
+  {
+      release_buffer();
+  }
+  TDynamicMatrix& operator=(const TDynamicMatrix& m)
+  {
+      if (this != &m) {
+          const bool propagate = alloc_traits::propagate_on_container_copy_assignment::value && (alloc != m.alloc);
+          if ((nRows * ld != m.nRows * m.ld) || propagate) {
+              Alloc a = propagate ? m.alloc : alloc;
+              T* p = tmatrix_detail::allocate_array(a, m.nRows * m.ld);
+              release_buffer();
+              alloc = a;
+              pMem = p;
           }
+          nRows = m.nRows;
+          nCols = m.nCols;
+          ld = m.ld;
+          copy(m.pMem, m.pMem + nRows * ld, pMem);
+      }
+      return *this;
+  }
+  TDynamicMatrix& operator=(TDynamicMatrix&& m)
+    noexcept(alloc_traits::propagate_on_container_move_assignment::value || alloc_traits::is_always_equal::value)
+  {
+      if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+          using std::swap;
+          swap(alloc, m.alloc);
+      }
+      else if ((alloc != m.alloc) && ((owner == nullptr) || (m.owner == nullptr)))
+          return *this = static_cast<const TDynamicMatrix&>(m);
+      swap_storage(m);
+      return *this;
+  }
+  template<typename E>
+  TDynamicMatrix& operator=(const TMatExpr<E>& e)
+  {
+      if ((nRows != e.self().rows()) || (nCols != e.self().cols())
+          || e.self().aliases(pMem, nRows * ld * sizeof(T))) {
+          TDynamicMatrix tmp(e, alloc);
+          swap(*this, tmp);
       }
+      else
+          tmatrix_detail::expr_assign(pMem, ld, e.self());
+      return *this;
   }
 
+  allocator_type get_allocator() const { return alloc; }
+  size_t rows() const noexcept { return nRows; }
+  size_t cols() const noexcept { return nCols; }
+  // число строк (для квадратной матрицы - её порядок)
+  size_t size() const noexcept { return nRows; }
+  // расстояние между началами соседних строк в элементах
+  size_t stride() const noexcept { return ld; }
+
+  // непосредственный доступ к буферу (rows*stride элементов построчно)
+  T* data() noexcept { return pMem; }
+  const T* data() const noexcept { return pMem; }
+  const T& eval(size_t i, size_t j) const noexcept { return pMem[i * ld + j]; }
+  bool aliases(const void*, size_t) const noexcept { return false; }
+
+  // индексация
+  TVectorView<T> operator[](size_t ind)
+  {
+      TMATRIX_CHECK_INDEX(ind, nRows, "index of row is more than a size of matrix");
+      return TVectorView<T>(pMem + ind * ld, nCols);
+  }
+  TVectorView<const T> operator[](size_t ind) const
+  {
+      TMATRIX_CHECK_INDEX(ind, nRows, "index of row is more than a size of matrix");
+      return TVectorView<const T>(pMem + ind * ld, nCols);
+  }
+  // индексация с контролем (строка; элементы - через at() представления)
+  TVectorView<T> at(size_t ind)
+  {
+      if (ind >= nRows)
+          throw out_of_range("index of row is more than a size of matrix");
+      return TVectorView<T>(pMem + ind * ld, nCols);
+  }
+  TVectorView<const T> at(size_t ind) const
+  {
+      if (ind >= nRows)
+          throw out_of_range("index of row is more than a size of matrix");
+      return TVectorView<const T>(pMem + ind * ld, nCols);
+  }
+
+  // срезы без копирования (см. одноимённые методы TMatrixView)
+  TMatrixView<T> submatrix(size_t i, size_t j, size_t rows, size_t cols)
+  {
+      return TMatrixView<T>(*this).submatrix(i, j, rows, cols);
+  }
+  TMatrixView<const T> submatrix(size_t i, size_t j, size_t rows, size_t cols) const
+  {
+      return TMatrixView<const T>(*this).submatrix(i, j, rows, cols);
+  }
+  TMatrixView<T> row_range(size_t i, size_t count)
+  {
+      return TMatrixView<T>(*this).row_range(i, count);
+  }
+  TMatrixView<const T> row_range(size_t i, size_t count) const
+  {
+      return TMatrixView<const T>(*this).row_range(i, count);
+  }
+  TStridedVectorView<T> column(size_t j)
+  {
+      return TMatrixView<T>(*this).column(j);
+  }
+  TStridedVectorView<const T> column(size_t j) const
+  {
+      return TMatrixView<const T>(*this).column(j);
+  }
+  TStridedVectorView<T> diagonal(ptrdiff_t k = 0)
+  {
+      return TMatrixView<T>(*this).diagonal(k);
+  }
+  TStridedVectorView<const T> diagonal(ptrdiff_t k = 0) const
+  {
+      return TMatrixView<const T>(*this).diagonal(k);
+  }
+
+  // транспонирование квадратной матрицы на месте
+  void transpose_inplace()
+  {
+      TMatrixView<T>(*this).transpose_inplace();
+  }
+
+  // составное присваивание - результат пишется прямо в pMem
+  template<typename E>
+  TDynamicMatrix& operator+=(const TMatExpr<E>& e)
+  {
+      if ((nRows != e.self().rows()) || (nCols != e.self().cols()))
+          throw invalid_argument("matrix's sizes should be the same");
+      if (e.self().aliases(pMem, nRows * ld * sizeof(T)))
+          return *this += TDynamicMatrix(e, alloc);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpAdd>(pMem, ld, e.self());
+      return *this;
+  }
+  template<typename E>
+  TDynamicMatrix& operator-=(const TMatExpr<E>& e)
+  {
+      if ((nRows != e.self().rows()) || (nCols != e.self().cols()))
+          throw invalid_argument("matrix's sizes should be the same");
+      if (e.self().aliases(pMem, nRows * ld * sizeof(T)))
+          return *this -= TDynamicMatrix(e, alloc);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpSub>(pMem, ld, e.self());
+      return *this;
+  }
+  TDynamicMatrix& operator*=(const T& val)
+  {
+      tmatrix_detail::expr_assign(pMem, ld, *this * val);
+      return *this;
+  }
+
+  friend void swap(TDynamicMatrix& lhs, TDynamicMatrix& rhs) noexcept
+  {
+    if constexpr (alloc_traits::propagate_on_container_swap::value) {
+      using std::swap;
+      swap(lhs.alloc, rhs.alloc);
+    }
+    lhs.swap_storage(rhs);
+  }
+
+private:
+  void swap_storage(TDynamicMatrix& m) noexcept
+  {
+    std::swap(nRows, m.nRows);
+    std::swap(nCols, m.nCols);
+    std::swap(ld, m.ld);
+    std::swap(pMem, m.pMem);
+    std::swap(owner, m.owner);
+  }
+public:
+
   // ввод/вывод
   friend istream& operator>>(istream& istr, TDynamicMatrix& v)
   {
-      for (size_t i = 0; i < v.sz; i++)
-          istr >> v[i]; // требуется оператор>> для типа T
+      for (size_t i = 0; i < v.nRows; i++)
+          tmatrix_detail::read_values(istr, v.pMem + i * v.ld, v.nCols);
       return istr;
   }
   friend ostream& operator<<(ostream& ostr, const TDynamicMatrix& v)
   {
-      for (size_t i = 0; i < v.sz; i++)
-          ostr << v[i] << endl; // требуется оператор>> для типа T
+      tmatrix_detail::write_rows(ostr, v.pMem, v.nRows, v.nCols, v.ld);
+      return ostr;
+  }
+};
+
+
+// Представление матрицы -
+// невладеющая ссылка на rows x cols элементов чужой памяти, лежащих
+// построчно с шагом stride() >= cols(). Участвует во всех матричных
+// операциях наравне с TDynamicMatrix; TMatrixView<const T> - только чтение
+template<typename T>
+class TMatrixView : public TMatExpr<TMatrixView<T>>
+{
+protected:
+  size_t nRows, nCols, ld;
+  T* pMem;
+public:
+  typedef typename remove_const<T>::type value_type;
+
+  TMatrixView(T* p, size_t rows, size_t cols) : nRows(rows), nCols(cols), ld(cols), pMem(p) {}
+  TMatrixView(T* p, size_t rows, size_t cols, size_t stride) : nRows(rows), nCols(cols), ld(stride), pMem(p)
+  {
+    if (ld < nCols)
+        throw invalid_argument("row stride should not be less than the number of columns");
+  }
+  template<typename A>
+  TMatrixView(TDynamicMatrix<value_type, A>& m) : nRows(m.rows()), nCols(m.cols()), ld(m.stride()), pMem(m.data()) {}
+  template<typename A, typename U = T, typename = enable_if_t<is_const<U>::value>>
+  TMatrixView(const TDynamicMatrix<value_type, A>& m) : nRows(m.rows()), nCols(m.cols()), ld(m.stride()), pMem(m.data()) {}
+
+  operator TMatrixView<const T>() const noexcept { return TMatrixView<const T>(pMem, nRows, nCols, ld); }
+
+  size_t rows() const noexcept { return nRows; }
+  size_t cols() const noexcept { return nCols; }
+  size_t size() const noexcept { return nRows; }
+  size_t stride() const noexcept { return ld; }
+  T* data() const noexcept { return pMem; }
+  const T& eval(size_t i, size_t j) const noexcept { return pMem[i * ld + j]; }
+  // назначение того же вида передаёт nRows * ld * sizeof(T) байтов
+  bool aliases(const void* p, size_t bytes) const noexcept
+  {
+      const size_t span = nRows == 0 ? 0 : ((nRows - 1) * ld + nCols) * sizeof(T);
+      return tmatrix_detail::view_aliases(p, bytes, pMem, span, nRows * ld * sizeof(T));
+  }
+
+  // индексация
+  TVectorView<T> operator[](size_t ind) const
+  {
+      TMATRIX_CHECK_INDEX(ind, nRows, "index of row is more than a size of matrix");
+      return TVectorView<T>(pMem + ind * ld, nCols);
+  }
+  // индексация с контролем
+  TVectorView<T> at(size_t ind) const
+  {
+      if (ind >= nRows)
+          throw out_of_range("index of row is more than a size of matrix");
+      return TVectorView<T>(pMem + ind * ld, nCols);
+  }
+
+  // блок rows x cols с левым верхним углом (i, j); шаг строки сохраняется,
+  // поэтому блок сразу годится для SIMD-ядер и GEMM
+  TMatrixView submatrix(size_t i, size_t j, size_t rows, size_t cols) const
+  {
+      if ((i > nRows) || (rows > nRows - i) || (j > nCols) || (cols > nCols - j))
+          throw out_of_range("submatrix is out of the bounds of matrix");
+      return TMatrixView(pMem + i * ld + j, rows, cols, ld);
+  }
+  // строки [i, i + count)
+  TMatrixView row_range(size_t i, size_t count) const
+  {
+      return submatrix(i, 0, count, nCols);
+  }
+  // столбец j - элементы через stride()
+  TStridedVectorView<T> column(size_t j) const
+  {
+      if (j >= nCols)
+          throw out_of_range("index of column is more than a size of matrix");
+      return TStridedVectorView<T>(pMem + j, nRows, ld);
+  }
+  // диагональ k: 0 - главная, k > 0 - выше неё, k < 0 - ниже
+  TStridedVectorView<T> diagonal(ptrdiff_t k = 0) const
+  {
+      const size_t i = k < 0 ? size_t(-k) : 0, j = k > 0 ? size_t(k) : 0;
+      if ((i >= nRows) || (j >= nCols))
+          throw out_of_range("diagonal is out of the bounds of matrix");
+      return TStridedVectorView<T>(pMem + i * ld + j, min(nRows - i, nCols - j), ld + 1);
+  }
+
+  // транспонирование квадратной матрицы (блока) на месте
+  void transpose_inplace() const
+  {
+      if (nRows != nCols)
+          throw invalid_argument("matrix should be square");
+      tmatrix_detail::transpose_square(nRows, pMem, ld);
+  }
+
+  // поэлементное копирование в представляемую память (размеры не меняются)
+  template<typename E>
+  const TMatrixView& operator=(const TMatExpr<E>& e) const
+  {
+      if ((nRows != e.self().rows()) || (nCols != e.self().cols()))
+          throw invalid_argument("matrix's sizes should be the same");
+      if (e.self().aliases(pMem, nRows * ld * sizeof(T)))
+          return *this = TDynamicMatrix<value_type>(e);
+      tmatrix_detail::expr_assign(pMem, ld, e.self());
+      return *this;
+  }
+  // копия ссылается на ту же память, присваивание копирует элементы
+  TMatrixView(const TMatrixView&) = default;
+  const TMatrixView& operator=(const TMatrixView& m) const
+  {
+      return *this = static_cast<const TMatExpr<TMatrixView>&>(m);
+  }
+
+  // составное присваивание
+  template<typename E>
+  const TMatrixView& operator+=(const TMatExpr<E>& e) const
+  {
+      if ((nRows != e.self().rows()) || (nCols != e.self().cols()))
+          throw invalid_argument("matrix's sizes should be the same");
+      if (e.self().aliases(pMem, nRows * ld * sizeof(T)))
+          return *this += TDynamicMatrix<value_type>(e);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpAdd>(pMem, ld, e.self());
+      return *this;
+  }
+  template<typename E>
+  const TMatrixView& operator-=(const TMatExpr<E>& e) const
+  {
+      if ((nRows != e.self().rows()) || (nCols != e.self().cols()))
+          throw invalid_argument("matrix's sizes should be the same");
+      if (e.self().aliases(pMem, nRows * ld * sizeof(T)))
+          return *this -= TDynamicMatrix<value_type>(e);
+      tmatrix_detail::expr_update<tmatrix_detail::TOpSub>(pMem, ld, e.self());
+      return *this;
+  }
+  const TMatrixView& operator*=(const value_type& val) const
+  {
+      tmatrix_detail::expr_assign(pMem, ld, *this * val);
+      return *this;
+  }
+
+  // ввод/вывод
+  friend istream& operator>>(istream& istr, TMatrixView v)
+  {
+      for (size_t i = 0; i < v.nRows; i++)
+          tmatrix_detail::read_values(istr, v.pMem + i * v.ld, v.nCols);
+      return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TMatrixView& v)
+  {
+      tmatrix_detail::write_rows(ostr, v.pMem, v.nRows, v.nCols, v.ld);
       return ostr;
   }
 };
+
+
+namespace tmatrix_detail
+{
+  // операнды произведений: контейнеры и представления используются как есть,
+  // прочие выражения вычисляются во временный объект
+  template<typename T, typename A>
+  const TDynamicVector<T, A>& as_vector(const TDynamicVector<T, A>& v) { return v; }
+  template<typename T>
+  TVectorView<const T> as_vector(const TVectorView<T>& v) { return v; }
+  template<typename E>
+  TDynamicVector<typename E::value_type> as_vector(const TVecExpr<E>& e) { return e; }
+
+  template<typename T, typename A>
+  const TDynamicMatrix<T, A>& as_matrix(const TDynamicMatrix<T, A>& m) { return m; }
+  template<typename T>
+  TMatrixView<const T> as_matrix(const TMatrixView<T>& m) { return m; }
+  template<typename E>
+  TDynamicMatrix<typename E::value_type> as_matrix(const TMatExpr<E>& e) { return e; }
+}
+
+// скалярное произведение
+template<typename L, typename R>
+typename L::value_type operator*(const TVecExpr<L>& lhs, const TVecExpr<R>& rhs)
+{
+  const auto& l = tmatrix_detail::as_vector(lhs.self());
+  const auto& r = tmatrix_detail::as_vector(rhs.self());
+  if (l.size() != r.size())
+    throw invalid_argument("the length of the vectors must be the same");
+  return tmatrix_detail::vec_dot(l.data(), r.data(), l.size());
+}
+
+// матрично-векторные операции: узел выражения, поэтому y += A * x
+// накапливает результат прямо в y
+template<typename L, typename R>
+TMatVec<decltype(tmatrix_detail::as_matrix(declval<const L&>())), decltype(tmatrix_detail::as_vector(declval<const R&>()))>
+operator*(const TMatExpr<L>& lhs, const TVecExpr<R>& rhs)
+{
+  return TMatVec<decltype(tmatrix_detail::as_matrix(declval<const L&>())), decltype(tmatrix_detail::as_vector(declval<const R&>()))>(
+    tmatrix_detail::as_matrix(lhs.self()), tmatrix_detail::as_vector(rhs.self()));
+}
+
+// вектор-матричное произведение x^T A (длина x - число строк A)
+template<typename L, typename R>
+TVecMat<decltype(tmatrix_detail::as_vector(declval<const L&>())), decltype(tmatrix_detail::as_matrix(declval<const R&>()))>
+operator*(const TVecExpr<L>& lhs, const TMatExpr<R>& rhs)
+{
+  return TVecMat<decltype(tmatrix_detail::as_vector(declval<const L&>())), decltype(tmatrix_detail::as_matrix(declval<const R&>()))>(
+    tmatrix_detail::as_vector(lhs.self()), tmatrix_detail::as_matrix(rhs.self()));
+}
+
+// транспонированная матрица (cols x rows), блочное копирование
+template<typename E>
+TDynamicMatrix<typename E::value_type> transpose(const TMatExpr<E>& m)
+{
+  const auto& a = tmatrix_detail::as_matrix(m.self());
+  TDynamicMatrix<typename E::value_type> tmp(a.cols(), a.rows());
+  tmatrix_detail::transpose_copy(a.rows(), a.cols(), a.data(), a.stride(), tmp.data(), tmp.stride());
+  return tmp;
+}
+
+// матрично-матричные операции: (m x k) * (k x n) = (m x n)
+template<typename L, typename R>
+TDynamicMatrix<typename L::value_type> operator*(const TMatExpr<L>& lhs, const TMatExpr<R>& rhs)
+{
+  typedef typename L::value_type T;
+  const auto& a = tmatrix_detail::as_matrix(lhs.self());
+  const auto& b = tmatrix_detail::as_matrix(rhs.self());
+  if (a.cols() != b.rows())
+    throw invalid_argument("the number of columns of the left matrix must be equal to the number of rows of the right one");
+  const size_t m = a.rows(), n = b.cols(), k = a.cols();
+  TDynamicMatrix<T> tmp(m, n, zero_init);
+  tmatrix_detail::gemm(m, n, k, a.data(), a.stride(), b.data(), b.stride(), tmp.data(), tmp.stride());
+  return tmp;
+}
+
+// Операции над истекающим операндом (f() + v, A + B * C): результат
+// вычисляется в его буфере, новая память не выделяется
+template<typename T, typename A, typename R>
+TDynamicVector<T, A> operator+(TDynamicVector<T, A>&& l, const TVecExpr<R>& r)
+{
+  l += r;
+  return std::move(l);
+}
+template<typename L, typename T, typename A>
+TDynamicVector<T, A> operator+(const TVecExpr<L>& l, TDynamicVector<T, A>&& r)
+{
+  r += l;
+  return std::move(r);
+}
+template<typename T, typename A>
+TDynamicVector<T, A> operator+(TDynamicVector<T, A>&& l, TDynamicVector<T, A>&& r)
+{
+  l += r;
+  return std::move(l);
+}
+template<typename T, typename A, typename R>
+TDynamicVector<T, A> operator-(TDynamicVector<T, A>&& l, const TVecExpr<R>& r)
+{
+  l -= r;
+  return std::move(l);
+}
+template<typename L, typename T, typename A>
+TDynamicVector<T, A> operator-(const TVecExpr<L>& l, TDynamicVector<T, A>&& r)
+{
+  r = l - r;
+  return std::move(r);
+}
+template<typename T, typename A>
+TDynamicVector<T, A> operator-(TDynamicVector<T, A>&& l, TDynamicVector<T, A>&& r)
+{
+  l -= r;
+  return std::move(l);
+}
+template<typename T, typename A>
+TDynamicVector<T, A> operator+(TDynamicVector<T, A>&& l, const typename TDynamicVector<T, A>::value_type& val)
+{
+  l += val;
+  return std::move(l);
+}
+template<typename T, typename A>
+TDynamicVector<T, A> operator-(TDynamicVector<T, A>&& l, const typename TDynamicVector<T, A>::value_type& val)
+{
+  l -= val;
+  return std::move(l);
+}
+template<typename T, typename A>
+TDynamicVector<T, A> operator*(TDynamicVector<T, A>&& l, const typename TDynamicVector<T, A>::value_type& val)
+{
+  l *= val;
+  return std::move(l);
+}
+
+template<typename T, typename A, typename R>
+TDynamicMatrix<T, A> operator+(TDynamicMatrix<T, A>&& l, const TMatExpr<R>& r)
+{
+  l += r;
+  return std::move(l);
+}
+template<typename L, typename T, typename A>
+TDynamicMatrix<T, A> operator+(const TMatExpr<L>& l, TDynamicMatrix<T, A>&& r)
+{
+  r += l;
+  return std::move(r);
+}
+template<typename T, typename A>
+TDynamicMatrix<T, A> operator+(TDynamicMatrix<T, A>&& l, TDynamicMatrix<T, A>&& r)
+{
+  l += r;
+  return std::move(l);
+}
+template<typename T, typename A, typename R>
+TDynamicMatrix<T, A> operator-(TDynamicMatrix<T, A>&& l, const TMatExpr<R>& r)
+{
+  l -= r;
+  return std::move(l);
+}
+template<typename L, typename T, typename A>
+TDynamicMatrix<T, A> operator-(const TMatExpr<L>& l, TDynamicMatrix<T, A>&& r)
+{
+  r = l - r;
+  return std::move(r);
+}
+template<typename T, typename A>
+TDynamicMatrix<T, A> operator-(TDynamicMatrix<T, A>&& l, TDynamicMatrix<T, A>&& r)
+{
+  l -= r;
+  return std::move(l);
+}
+template<typename T, typename A>
+TDynamicMatrix<T, A> operator*(TDynamicMatrix<T, A>&& l, const typename TDynamicMatrix<T, A>::value_type& val)
+{
+  l *= val;
+  return std::move(l);
+}
 #endif
@@ -0,0 +1,286 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Двоичный формат векторов и матриц и загрузка через отображение файла
+//
+// Файл: заголовок 64 байта, затем элементы построчно с шагом stride
+// начиная со смещения offset (кратного alignment, 64 по умолчанию).
+// Заголовок (все поля little-endian):
+//    0  char[8]  сигнатура "\x89TMX\r\n\x1a\n"
+//    8  uint16   версия формата (1)
+//   10  uint8    тип элементов (TBinaryType)
+//   11  uint8    флаги: бит 0 - элементы big-endian
+//   12  uint8    размерность: 1 - вектор, 2 - матрица
+//   13  uint8[3] резерв
+//   16  uint32   размер элемента в байтах
+//   20  uint32   выравнивание данных
+//   24  uint64   строк (у вектора - длина)
+//   32  uint64   столбцов (у вектора - 1)
+//   40  uint64   шаг строки в элементах
+//   48  uint64   смещение данных от начала файла
+//   56  uint64   резерв
+// map_binary_* отображают файл в память (copy-on-write) и возвращают
+// объект, владеющий отображением, - данные не читаются и не копируются,
+// страницы подгружаются ОС при первом обращении.
+
+#ifndef __TMATRIX_BINARY_H__
+#define __TMATRIX_BINARY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include "tmatrix.h"
+
+namespace tmatrix_detail
+{
+  enum TBinaryType : uint8_t
+  {
+    BIN_INT8 = 1, BIN_INT16, BIN_INT32, BIN_INT64,
+    BIN_UINT8, BIN_UINT16, BIN_UINT32, BIN_UINT64,
+    BIN_FLOAT32, BIN_FLOAT64
+  };
+
+  // код типа элементов; для прочих типов двоичный формат не определён
+  template<typename T> struct TBinaryTypeOf;
+  template<> struct TBinaryTypeOf<int8_t> { static const TBinaryType value = BIN_INT8; };
+  template<> struct TBinaryTypeOf<int16_t> { static const TBinaryType value = BIN_INT16; };
+  template<> struct TBinaryTypeOf<int32_t> { static const TBinaryType value = BIN_INT32; };
+  template<> struct TBinaryTypeOf<int64_t> { static const TBinaryType value = BIN_INT64; };
+  template<> struct TBinaryTypeOf<uint8_t> { static const TBinaryType value = BIN_UINT8; };
+  template<> struct TBinaryTypeOf<uint16_t> { static const TBinaryType value = BIN_UINT16; };
+  template<> struct TBinaryTypeOf<uint32_t> { static const TBinaryType value = BIN_UINT32; };
+  template<> struct TBinaryTypeOf<uint64_t> { static const TBinaryType value = BIN_UINT64; };
+  template<> struct TBinaryTypeOf<float> { static const TBinaryType value = BIN_FLOAT32; };
+  template<> struct TBinaryTypeOf<double> { static const TBinaryType value = BIN_FLOAT64; };
+
+  const size_t BINARY_HEADER_SIZE = 64;
+
+  struct TBinaryHeader
+  {
+    uint16_t version;
+    uint8_t type;
+    bool bigEndian;
+    uint8_t dims;
+    uint32_t elemSize;
+    uint32_t alignment;
+    uint64_t rows, cols, stride, offset;
+  };
+
+  bool host_big_endian() noexcept;
+  // заголовок для данных типа type; данные начинаются сразу после него
+  TBinaryHeader make_binary_header(uint8_t type, size_t elemSize, size_t dims, size_t rows, size_t cols);
+  void encode_binary_header(const TBinaryHeader& h, unsigned char* buf);
+  // разбор и проверка заголовка; fileSize = 0 - размер файла неизвестен
+  TBinaryHeader decode_binary_header(const unsigned char* buf, uint64_t fileSize);
+  void reverse_bytes(void* p, size_t elemSize, size_t n) noexcept;
+
+  // отображение файла целиком (copy-on-write: запись в память не меняет файл)
+  struct TFileMapping
+  {
+    void* base;
+    size_t length;
+  };
+  TFileMapping map_file(const std::string& path);
+  void unmap_file(void* base, size_t length) noexcept;
+
+  // отображение файла, освобождаемое при выходе из области видимости
+  class TMappedFile
+  {
+    TFileMapping fm;
+  public:
+    explicit TMappedFile(const std::string& path) : fm(map_file(path)) {}
+    TMappedFile(const TMappedFile&) = delete;
+    TMappedFile& operator=(const TMappedFile&) = delete;
+    ~TMappedFile() { unmap_file(fm.base, fm.length); }
+
+    const char* begin() const noexcept { return static_cast<const char*>(fm.base); }
+    const char* end() const noexcept { return begin() + fm.length; }
+  };
+
+  template<typename T>
+  void check_binary_header(const TBinaryHeader& h, size_t dims)
+  {
+    if ((h.type != TBinaryTypeOf<T>::value) || (h.elemSize != sizeof(T)))
+      throw std::invalid_argument("the element type of the file does not match");
+    if (h.dims != dims)
+      throw std::invalid_argument(dims == 1 ? "the file does not contain a vector" : "the file does not contain a matrix");
+  }
+
+  // строки данных без заголовка, в порядке байтов машины
+  template<typename T>
+  void write_binary_rows(std::ostream& os, size_t rows, size_t cols, const T* p, size_t ld)
+  {
+    for (size_t i = 0; i < rows && os; i++)
+      os.write(reinterpret_cast<const char*>(p + i * ld), std::streamsize(cols * sizeof(T)));
+    if (!os)
+      throw std::runtime_error("cannot write binary data");
+  }
+
+  template<typename T>
+  void write_binary(std::ostream& os, size_t dims, size_t rows, size_t cols, const T* p, size_t ld)
+  {
+    const TBinaryHeader h = make_binary_header(TBinaryTypeOf<T>::value, sizeof(T), dims, rows, cols);
+    unsigned char buf[BINARY_HEADER_SIZE];
+    encode_binary_header(h, buf);
+    os.write(reinterpret_cast<const char*>(buf), BINARY_HEADER_SIZE);
+    write_binary_rows(os, rows, cols, p, ld);
+  }
+
+  // чтение строк данных в буфер с шагом ld; поток стоит в начале данных
+  template<typename T>
+  void read_binary_rows(std::istream& is, const TBinaryHeader& h, T* p, size_t ld)
+  {
+    for (size_t i = 0; i < h.rows; i++) {
+      is.read(reinterpret_cast<char*>(p + i * ld), std::streamsize(h.cols * sizeof(T)));
+      is.ignore(std::streamsize((h.stride - h.cols) * sizeof(T)));
+      if (!is)
+        throw std::runtime_error("unexpected end of binary data");
+      if (h.bigEndian != host_big_endian())
+        reverse_bytes(p + i * ld, sizeof(T), h.cols);
+    }
+  }
+
+  inline TBinaryHeader read_binary_header(std::istream& is)
+  {
+    unsigned char buf[BINARY_HEADER_SIZE];
+    if (!is.read(reinterpret_cast<char*>(buf), BINARY_HEADER_SIZE))
+      throw std::runtime_error("unexpected end of binary data");
+    const TBinaryHeader h = decode_binary_header(buf, 0);
+    is.ignore(std::streamsize(h.offset - BINARY_HEADER_SIZE)); // к началу данных
+    return h;
+  }
+
+  inline void open_for_reading(std::ifstream& f, const std::string& path)
+  {
+    f.open(path.c_str(), std::ios::binary);
+    if (!f)
+      throw std::runtime_error("cannot open file " + path);
+  }
+
+  inline void open_for_writing(std::ofstream& f, const std::string& path)
+  {
+    f.open(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!f)
+      throw std::runtime_error("cannot create file " + path);
+  }
+}
+
+// запись в двоичном формате (поток должен быть открыт в режиме binary)
+template<typename E>
+void save_binary(std::ostream& os, const TVecExpr<E>& v)
+{
+  const auto& a = tmatrix_detail::as_vector(v.self());
+  tmatrix_detail::write_binary(os, 1, a.size(), 1, a.data(), 1);
+}
+
+template<typename E>
+void save_binary(std::ostream& os, const TMatExpr<E>& m)
+{
+  const auto& a = tmatrix_detail::as_matrix(m.self());
+  tmatrix_detail::write_binary(os, 2, a.rows(), a.cols(), a.data(), a.stride());
+}
+
+template<typename E>
+void save_binary(const std::string& path, const TVecExpr<E>& v)
+{
+  std::ofstream f;
+  tmatrix_detail::open_for_writing(f, path);
+  save_binary(f, v);
+}
+
+template<typename E>
+void save_binary(const std::string& path, const TMatExpr<E>& m)
+{
+  std::ofstream f;
+  tmatrix_detail::open_for_writing(f, path);
+  save_binary(f, m);
+}
+
+// чтение с копированием в новый объект (порядок байтов исправляется)
+template<typename T>
+TDynamicVector<T> load_binary_vector(std::istream& is)
+{
+  const tmatrix_detail::TBinaryHeader h = tmatrix_detail::read_binary_header(is);
+  tmatrix_detail::check_binary_header<T>(h, 1);
+  TDynamicVector<T> v(h.rows);
+  tmatrix_detail::read_binary_rows(is, h, v.data(), 1);
+  return v;
+}
+
+template<typename T>
+TDynamicMatrix<T> load_binary_matrix(std::istream& is)
+{
+  const tmatrix_detail::TBinaryHeader h = tmatrix_detail::read_binary_header(is);
+  tmatrix_detail::check_binary_header<T>(h, 2);
+  TDynamicMatrix<T> m(h.rows, h.cols);
+  tmatrix_detail::read_binary_rows(is, h, m.data(), m.stride());
+  return m;
+}
+
+template<typename T>
+TDynamicVector<T> load_binary_vector(const std::string& path)
+{
+  std::ifstream f;
+  tmatrix_detail::open_for_reading(f, path);
+  return load_binary_vector<T>(f);
+}
+
+template<typename T>
+TDynamicMatrix<T> load_binary_matrix(const std::string& path)
+{
+  std::ifstream f;
+  tmatrix_detail::open_for_reading(f, path);
+  return load_binary_matrix<T>(f);
+}
+
+// Загрузка без копирования: результат владеет отображением файла и
+// освобождает его при разрушении. Файл с другим порядком байтов или с
+// дополненными строками читается обычным образом (load_binary_*)
+template<typename T>
+TDynamicVector<T> map_binary_vector(const std::string& path)
+{
+  const tmatrix_detail::TFileMapping fm = tmatrix_detail::map_file(path);
+  tmatrix_detail::TBinaryHeader h;
+  try {
+    h = tmatrix_detail::decode_binary_header(static_cast<const unsigned char*>(fm.base), fm.length);
+    tmatrix_detail::check_binary_header<T>(h, 1);
+  }
+  catch (...) {
+    tmatrix_detail::unmap_file(fm.base, fm.length);
+    throw;
+  }
+  if ((h.bigEndian != tmatrix_detail::host_big_endian()) || (h.stride != 1)) {
+    tmatrix_detail::unmap_file(fm.base, fm.length);
+    return load_binary_vector<T>(path);
+  }
+  T* p = reinterpret_cast<T*>(static_cast<char*>(fm.base) + h.offset);
+  return TDynamicVector<T>(adopt_buffer, p, h.rows, [fm](T*) { tmatrix_detail::unmap_file(fm.base, fm.length); });
+}
+
+template<typename T>
+TDynamicMatrix<T> map_binary_matrix(const std::string& path)
+{
+  const tmatrix_detail::TFileMapping fm = tmatrix_detail::map_file(path);
+  tmatrix_detail::TBinaryHeader h;
+  try {
+    h = tmatrix_detail::decode_binary_header(static_cast<const unsigned char*>(fm.base), fm.length);
+    tmatrix_detail::check_binary_header<T>(h, 2);
+  }
+  catch (...) {
+    tmatrix_detail::unmap_file(fm.base, fm.length);
+    throw;
+  }
+  if ((h.bigEndian != tmatrix_detail::host_big_endian()) || (h.stride != h.cols)) {
+    tmatrix_detail::unmap_file(fm.base, fm.length);
+    return load_binary_matrix<T>(path);
+  }
+  T* p = reinterpret_cast<T*>(static_cast<char*>(fm.base) + h.offset);
+  return TDynamicMatrix<T>(adopt_buffer, p, h.rows, h.cols, [fm](T*) { tmatrix_detail::unmap_file(fm.base, fm.length); });
+}
+#endif
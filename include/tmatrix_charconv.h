@@ -0,0 +1,289 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Разбор и запись чисел без форматированного ввода/вывода iostream
+//
+// Числа читаются std::from_chars - без локали и без sentry на каждый
+// элемент. Операторы >> векторов и матриц берут символы прямо из буфера
+// потока (streambuf), поэтому поток остаётся сразу за последним
+// прочитанным числом, как и при обычном вводе.
+// Операторы << пишут числа std::to_chars в буфер TEXT_BUFFER_SIZE байтов
+// и отдают его потоку целиком (без сброса потока после каждой строки).
+// Точность и формат вещественных чисел берутся из потока (setprecision,
+// fixed, scientific), разделитель элементов задаётся манипулятором
+// text_format.
+
+#ifndef __TMATRIX_CHARCONV_H__
+#define __TMATRIX_CHARCONV_H__
+
+#include <cstddef>
+#include <charconv>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <system_error>
+#include <type_traits>
+
+namespace tmatrix_detail
+{
+  // типы, которые разбираются from_chars; символьные типы и bool
+  // читаются оператором >> как обычно (символ, а не число)
+  template<typename T>
+  struct TFastText : std::integral_constant<bool,
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value
+    && !std::is_same<T, signed char>::value && !std::is_same<T, unsigned char>::value> {};
+
+  inline bool is_text_space(int c) noexcept
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+  }
+
+  // разделители элементов в текстовых файлах: пробельные символы, ',' и ';'
+  inline bool is_text_separator(char c) noexcept
+  {
+    return is_text_space(c) || c == ',' || c == ';';
+  }
+
+  // число в начале [first, last); возвращает указатель за ним или nullptr
+  template<typename T>
+  const char* parse_number(const char* first, const char* last, T& val) noexcept
+  {
+    if ((first != last) && (*first == '+')) { // from_chars не принимает '+'
+      ++first;
+      if ((first != last) && (*first == '-'))
+        return nullptr;
+    }
+    std::from_chars_result r;
+    if constexpr (std::is_floating_point<T>::value)
+      r = std::from_chars(first, last, val);
+    else
+      r = std::from_chars(first, last, val, 10);
+    return r.ec == std::errc() ? r.ptr : nullptr;
+  }
+
+  // n чисел, разделённых пробельными символами, из буфера потока;
+  // при ошибке выставляется failbit, как у оператора >>
+  template<typename T>
+  void read_text(std::istream& is, T* p, size_t n)
+  {
+    std::istream::sentry ok(is);
+    if (!ok)
+      return;
+    std::streambuf* sb = is.rdbuf();
+    char buf[256]; // самая длинная запись числа
+    for (size_t i = 0; i < n; i++) {
+      int c = sb->sgetc();
+      while ((c != EOF) && is_text_space(c))
+        c = sb->snextc();
+      size_t len = 0;
+      while ((c != EOF) && !is_text_space(c) && (len < sizeof(buf))) {
+        buf[len++] = char(c);
+        c = sb->snextc();
+      }
+      if (c == EOF)
+        is.setstate(std::ios::eofbit);
+      // запись длиннее буфера не делится на два числа - это ошибка
+      const bool tooLong = (c != EOF) && !is_text_space(c);
+      if ((len == 0) || tooLong || (parse_number(buf, buf + len, p[i]) != buf + len)) {
+        is.setstate(std::ios::failbit);
+        return;
+      }
+    }
+  }
+
+  // ввод n элементов p[0], p[step], ...
+  template<typename T>
+  void read_values(std::istream& is, T* p, size_t n, size_t step = 1)
+  {
+    if constexpr (TFastText<T>::value) {
+      if (step == 1) {
+        read_text(is, p, n);
+        return;
+      }
+      for (size_t i = 0; i < n && is; i++)
+        read_text(is, p + i * step, 1);
+    }
+    else
+      for (size_t i = 0; i < n; i++)
+        is >> p[i * step]; // требуется оператор>> для типа T
+  }
+
+  const size_t TEXT_BUFFER_SIZE = 64 * 1024;
+
+  // номера ячеек потока (ios_base::iword) с настройками text_format
+  inline int text_delimiter_slot()
+  {
+    static const int slot = std::ios_base::xalloc();
+    return slot;
+  }
+
+  inline int text_precision_slot()
+  {
+    static const int slot = std::ios_base::xalloc();
+    return slot;
+  }
+}
+
+// точность text_format: взять из потока (setprecision) или писать
+// кратчайшую запись, которая читается обратно без потерь
+const int TEXT_STREAM_PRECISION = -1;
+const int TEXT_SHORTEST = -2;
+
+// манипулятор формата вывода векторов и матриц:
+// cout << text_format(',', TEXT_SHORTEST) << m;
+struct TTextFormat
+{
+  char delimiter;
+  int precision;
+
+  friend std::ostream& operator<<(std::ostream& os, const TTextFormat& f)
+  {
+    // 0 в ячейке - значение по умолчанию
+    os.iword(tmatrix_detail::text_delimiter_slot()) = static_cast<unsigned char>(f.delimiter) + 1;
+    os.iword(tmatrix_detail::text_precision_slot()) = long(f.precision) - TEXT_STREAM_PRECISION;
+    return os;
+  }
+};
+
+inline TTextFormat text_format(char delimiter = ' ', int precision = TEXT_STREAM_PRECISION)
+{
+  return TTextFormat{ delimiter, precision };
+}
+
+namespace tmatrix_detail
+{
+  // запись элементов в поток через буфер; числа форматируются to_chars,
+  // если флаги потока не требуют обычного вывода (hex, showpos, ...)
+  class TTextWriter
+  {
+    std::ostream& os;
+    std::ostream::sentry ok;
+    char delim;
+    int precision;
+    std::chars_format format;
+    bool fastInt, fastFloat;
+    size_t len;
+    char buf[TEXT_BUFFER_SIZE];
+
+    template<typename T>
+    char* convert(char* first, char* last, const T& val) const
+    {
+      std::to_chars_result r;
+      if constexpr (std::is_floating_point<T>::value) {
+        if (precision == TEXT_SHORTEST)
+          r = format == std::chars_format::general ? std::to_chars(first, last, val) : std::to_chars(first, last, val, format);
+        else
+          r = std::to_chars(first, last, val, format, precision);
+      }
+      else
+        r = std::to_chars(first, last, val);
+      return r.ec == std::errc() ? r.ptr : nullptr;
+    }
+
+    void set_precision(int p)
+    {
+      precision = p == TEXT_STREAM_PRECISION ? int(os.precision()) : p;
+      if ((precision < 0) && (precision != TEXT_SHORTEST))
+        precision = 6; // как у printf
+    }
+  public:
+    // формат - из потока и манипулятора text_format
+    explicit TTextWriter(std::ostream& ostr) : os(ostr), ok(ostr), len(0)
+    {
+      const long d = os.iword(text_delimiter_slot());
+      delim = d == 0 ? ' ' : char(d - 1);
+      set_precision(int(os.iword(text_precision_slot()) + TEXT_STREAM_PRECISION));
+      const std::ios::fmtflags f = os.flags();
+      const std::ios::fmtflags ff = f & std::ios::floatfield;
+      format = ff == std::ios::fixed ? std::chars_format::fixed
+             : ff == std::ios::scientific ? std::chars_format::scientific : std::chars_format::general;
+      fastInt = !(f & (std::ios::showpos | std::ios::hex | std::ios::oct));
+      fastFloat = !(f & (std::ios::showpos | std::ios::showpoint | std::ios::uppercase))
+                  && (ff != (std::ios::fixed | std::ios::scientific));
+      os.width(0);
+    }
+    // формат задан явно, флаги потока не учитываются (файлы данных)
+    TTextWriter(std::ostream& ostr, const TTextFormat& fmt) : os(ostr), ok(ostr), delim(fmt.delimiter),
+      format(std::chars_format::general), fastInt(true), fastFloat(true), len(0)
+    {
+      set_precision(fmt.precision);
+      os.width(0);
+    }
+    TTextWriter(const TTextWriter&) = delete;
+    TTextWriter& operator=(const TTextWriter&) = delete;
+    ~TTextWriter() { flush(); }
+
+    char delimiter() const noexcept { return delim; }
+    explicit operator bool() const { return bool(ok) && bool(os); }
+
+    void flush()
+    {
+      if ((len != 0) && (os.rdbuf()->sputn(buf, std::streamsize(len)) != std::streamsize(len)))
+        os.setstate(std::ios::badbit);
+      len = 0;
+    }
+
+    void put(char c)
+    {
+      if (len == TEXT_BUFFER_SIZE)
+        flush();
+      buf[len++] = c;
+    }
+
+    void put(const char* str)
+    {
+      while (*str != '\0')
+        put(*str++);
+    }
+
+    template<typename T>
+    void value(const T& val)
+    {
+      if constexpr (TFastText<T>::value) {
+        if (std::is_floating_point<T>::value ? fastFloat : fastInt) {
+          char* e = convert(buf + len, buf + TEXT_BUFFER_SIZE, val);
+          if (e == nullptr) { // не поместилось - с начала пустого буфера
+            flush();
+            e = convert(buf, buf + TEXT_BUFFER_SIZE, val);
+            if (e == nullptr) {
+              os.setstate(std::ios::failbit);
+              return;
+            }
+          }
+          len = size_t(e - buf);
+          return;
+        }
+      }
+      flush();
+      os << val; // требуется оператор<< для типа T
+    }
+  };
+
+  // n элементов p[0], p[step], ..., каждый с разделителем после него
+  template<typename T>
+  void write_values(std::ostream& os, const T* p, size_t n, size_t step = 1)
+  {
+    TTextWriter w(os);
+    for (size_t i = 0; i < n && w; i++) {
+      w.value(p[i * step]);
+      w.put(w.delimiter());
+    }
+  }
+
+  // строки матрицы через разделитель, каждая - с новой строки текста
+  template<typename T>
+  void write_rows(std::ostream& os, const T* p, size_t rows, size_t cols, size_t ld)
+  {
+    TTextWriter w(os);
+    for (size_t i = 0; i < rows && w; i++) {
+      for (size_t j = 0; j < cols; j++) {
+        if (j != 0)
+          w.put(w.delimiter());
+        w.value(p[i * ld + j]);
+      }
+      w.put('\n');
+    }
+  }
+}
+#endif
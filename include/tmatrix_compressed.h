@@ -0,0 +1,253 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Сжатый двоичный формат матриц с доступом к отдельным блокам строк
+//
+// Матрица делится на блоки по blockRows строк; каждый блок сжимается
+// независимо, поэтому диапазон строк читается распаковкой только
+// содержащих его блоков. Перед сжатием байты элементов блока
+// переставляются (сначала младшие байты всех элементов, затем
+// следующие и т.д.): у чисел одного порядка и у нулей старшие байты
+// совпадают, и LZ-кодек (src/tmatrix_compressed.cpp) находит длинные
+// повторы. Блок, который не сжимается, хранится как есть.
+// Файл: заголовок 64 байта, блоки, индекс блоков в конце файла.
+// Заголовок (все поля little-endian):
+//    0  char[8]  сигнатура "\x89TMZ\r\n\x1a\n"
+//    8  uint16   версия формата (1)
+//   10  uint8    тип элементов (TBinaryType)
+//   11  uint8    флаги: бит 0 - элементы big-endian, бит 1 - байты переставлены
+//   12  uint32   размер элемента в байтах
+//   16  uint64   строк
+//   24  uint64   столбцов
+//   32  uint64   строк в блоке (в последнем блоке может быть меньше)
+//   40  uint64   число блоков
+//   48  uint64[2] резерв
+// Запись индекса блока - 16 байтов: смещение блока от начала файла и его
+// длина (равна длине исходных данных - блок не сжат).
+// Блоки сжимаются и распаковываются параллельно в пуле потоков, файл
+// читается через отображение в память: ОС подгружает только страницы
+// нужных блоков.
+
+#ifndef __TMATRIX_COMPRESSED_H__
+#define __TMATRIX_COMPRESSED_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tmatrix_binary.h"
+
+namespace tmatrix_detail
+{
+  const size_t COMPRESSED_HEADER_SIZE = 64;
+  const size_t COMPRESSED_INDEX_ENTRY = 16;
+  // столько байтов исходных данных в блоке по умолчанию (не меньше строки)
+  const size_t COMPRESSED_BLOCK_SIZE = 256 * 1024;
+
+  struct TCompressedHeader
+  {
+    uint8_t type;
+    bool bigEndian, shuffle;
+    uint32_t elemSize;
+    uint64_t rows, cols, blockRows, blocks;
+    uint64_t indexOffset; // не хранится: индекс занимает конец файла
+  };
+
+  void encode_compressed_header(const TCompressedHeader& h, unsigned char* buf);
+  TCompressedHeader decode_compressed_header(const unsigned char* buf, uint64_t fileSize);
+
+  // перестановка байтов count элементов: байт k элемента e <-> dst[k * count + e]
+  void shuffle_bytes(const unsigned char* src, unsigned char* dst, size_t count, size_t elemSize) noexcept;
+  void unshuffle_bytes(const unsigned char* src, unsigned char* dst, size_t count, size_t elemSize) noexcept;
+
+  // сжатие n байтов в dst; 0 - результат не помещается в capacity байтов
+  size_t lz_compress(const unsigned char* src, size_t n, unsigned char* dst, size_t capacity);
+  // распаковка ровно rawSize байтов; при повреждённых данных - исключение
+  void lz_decompress(const unsigned char* src, size_t n, unsigned char* dst, size_t rawSize);
+
+  // блок в формате файла (сжатый или, если не сжимается, исходный)
+  size_t compress_block(const unsigned char* raw, size_t n, size_t elemSize, bool shuffle, std::vector<unsigned char>& out);
+  void decompress_block(const unsigned char* src, size_t size, size_t elemSize, bool shuffle,
+                        unsigned char* dst, size_t rawSize, std::vector<unsigned char>& tmp);
+
+  template<typename T>
+  void write_compressed(std::ostream& os, size_t rows, size_t cols, const T* p, size_t ld, size_t blockRows)
+  {
+    const size_t rowBytes = cols * sizeof(T);
+    if (blockRows == 0)
+      blockRows = std::max<size_t>(1, COMPRESSED_BLOCK_SIZE / rowBytes);
+    blockRows = std::min(blockRows, rows);
+
+    TCompressedHeader h;
+    h.type = TBinaryTypeOf<T>::value;
+    h.bigEndian = host_big_endian();
+    h.shuffle = sizeof(T) > 1;
+    h.elemSize = uint32_t(sizeof(T));
+    h.rows = rows;
+    h.cols = cols;
+    h.blockRows = blockRows;
+    h.blocks = (rows - 1) / blockRows + 1;
+    unsigned char buf[COMPRESSED_HEADER_SIZE];
+    encode_compressed_header(h, buf);
+    os.write(reinterpret_cast<const char*>(buf), COMPRESSED_HEADER_SIZE);
+
+    // блоки сжимаются группами параллельно и пишутся по порядку
+    TThreadPool& pool = TThreadPool::instance();
+    const size_t group = pool.num_threads() * 2;
+    std::vector<std::vector<unsigned char>> out(group);
+    std::vector<unsigned char> index(h.blocks * COMPRESSED_INDEX_ENTRY);
+    uint64_t offset = COMPRESSED_HEADER_SIZE;
+    for (size_t g = 0; g < h.blocks && os; g += group) {
+      const size_t n = std::min<size_t>(group, h.blocks - g);
+      pool.parallel_for(n, blockRows * rowBytes, [&](size_t k0, size_t k1) {
+        std::vector<unsigned char> raw;
+        for (size_t k = k0; k < k1; k++) {
+          const size_t i = (g + k) * blockRows, count = std::min(blockRows, rows - i);
+          const unsigned char* src = reinterpret_cast<const unsigned char*>(p + i * ld);
+          if (ld != cols) { // строки с дополнением собираются подряд
+            raw.resize(count * rowBytes);
+            for (size_t r = 0; r < count; r++)
+              std::memcpy(raw.data() + r * rowBytes, p + (i + r) * ld, rowBytes);
+            src = raw.data();
+          }
+          compress_block(src, count * rowBytes, sizeof(T), h.shuffle, out[k]);
+        }
+      });
+      for (size_t k = 0; k < n; k++) {
+        unsigned char* e = index.data() + (g + k) * COMPRESSED_INDEX_ENTRY;
+        for (size_t b = 0; b < 8; b++) {
+          e[b] = static_cast<unsigned char>(offset >> (8 * b));
+          e[8 + b] = static_cast<unsigned char>(uint64_t(out[k].size()) >> (8 * b));
+        }
+        os.write(reinterpret_cast<const char*>(out[k].data()), std::streamsize(out[k].size()));
+        offset += out[k].size();
+      }
+    }
+    os.write(reinterpret_cast<const char*>(index.data()), std::streamsize(index.size()));
+    if (!os)
+      throw std::runtime_error("cannot write compressed data");
+  }
+}
+
+// запись в сжатом формате; blockRows = 0 - блоки около
+// COMPRESSED_BLOCK_SIZE байтов (поток должен быть открыт в режиме binary)
+template<typename E>
+void save_compressed(std::ostream& os, const TMatExpr<E>& m, size_t blockRows = 0)
+{
+  const auto& a = tmatrix_detail::as_matrix(m.self());
+  tmatrix_detail::write_compressed(os, a.rows(), a.cols(), a.data(), a.stride(), blockRows);
+}
+
+template<typename E>
+void save_compressed(const std::string& path, const TMatExpr<E>& m, size_t blockRows = 0)
+{
+  std::ofstream f;
+  tmatrix_detail::open_for_writing(f, path);
+  save_compressed(f, m, blockRows);
+}
+
+// Чтение сжатого файла: файл отображается в память, строки
+// распаковываются только из нужных блоков
+template<typename T>
+class TCompressedMatrixReader
+{
+  tmatrix_detail::TMappedFile file;
+  tmatrix_detail::TCompressedHeader h;
+
+  const unsigned char* base() const noexcept { return reinterpret_cast<const unsigned char*>(file.begin()); }
+
+  // данные блока b с проверкой записи индекса
+  const unsigned char* block(size_t b, size_t& size) const
+  {
+    const unsigned char* e = base() + h.indexOffset + b * tmatrix_detail::COMPRESSED_INDEX_ENTRY;
+    uint64_t offset = 0, len = 0;
+    for (size_t k = 0; k < 8; k++) {
+      offset |= uint64_t(e[k]) << (8 * k);
+      len |= uint64_t(e[8 + k]) << (8 * k);
+    }
+    if ((offset < tmatrix_detail::COMPRESSED_HEADER_SIZE) || (offset > h.indexOffset) || (len > h.indexOffset - offset))
+      throw std::invalid_argument("corrupted block index");
+    size = size_t(len);
+    return base() + offset;
+  }
+public:
+  explicit TCompressedMatrixReader(const std::string& path) : file(path)
+  {
+    h = tmatrix_detail::decode_compressed_header(base(), uint64_t(file.end() - file.begin()));
+    if ((h.type != tmatrix_detail::TBinaryTypeOf<T>::value) || (h.elemSize != sizeof(T)))
+      throw std::invalid_argument("the element type of the file does not match");
+  }
+
+  size_t rows() const noexcept { return size_t(h.rows); }
+  size_t cols() const noexcept { return size_t(h.cols); }
+  size_t block_rows() const noexcept { return size_t(h.blockRows); }
+
+  // строки [first, first + dst.rows()) в уже выделенную память dst
+  void read_rows(size_t first, TMatrixView<T> dst) const
+  {
+    using namespace tmatrix_detail;
+    if (dst.cols() != h.cols)
+      throw std::invalid_argument("the number of columns does not match");
+    if ((first > h.rows) || (dst.rows() > h.rows - first))
+      throw std::out_of_range("rows are out of the bounds of matrix");
+    if (dst.rows() == 0)
+      return;
+    const size_t last = first + dst.rows();
+    const size_t br = size_t(h.blockRows), rowBytes = size_t(h.cols) * sizeof(T);
+    const size_t b0 = first / br, b1 = (last - 1) / br + 1;
+    const bool swap = h.bigEndian != host_big_endian();
+
+    TThreadPool::instance().parallel_for(b1 - b0, br * rowBytes, [&](size_t k0, size_t k1) {
+      std::vector<unsigned char> raw, tmp;
+      for (size_t b = b0 + k0; b < b0 + k1; b++) {
+        const size_t i0 = b * br, i1 = std::min<size_t>(i0 + br, size_t(h.rows));
+        const size_t r0 = std::max(i0, first), r1 = std::min(i1, last);
+        size_t size;
+        const unsigned char* src = block(b, size);
+        // блок целиком в dst без дополнения строк - распаковка прямо на место
+        const bool direct = (r0 == i0) && (r1 == i1) && (dst.stride() == h.cols);
+        unsigned char* out;
+        if (direct)
+          out = reinterpret_cast<unsigned char*>(dst.data() + (i0 - first) * dst.stride());
+        else {
+          raw.resize((i1 - i0) * rowBytes);
+          out = raw.data();
+        }
+        decompress_block(src, size, sizeof(T), h.shuffle, out, (i1 - i0) * rowBytes, tmp);
+        for (size_t r = r0; r < r1; r++) {
+          T* row = dst.data() + (r - first) * dst.stride();
+          if (!direct)
+            std::memcpy(row, out + (r - i0) * rowBytes, rowBytes);
+          if (swap)
+            reverse_bytes(row, sizeof(T), size_t(h.cols));
+        }
+      }
+    });
+  }
+
+  TDynamicMatrix<T> read_rows(size_t first, size_t count) const
+  {
+    TDynamicMatrix<T> m(count, cols(), uninitialized_init);
+    read_rows(first, m);
+    return m;
+  }
+
+  TDynamicMatrix<T> read() const
+  {
+    return read_rows(0, rows());
+  }
+};
+
+template<typename T>
+TDynamicMatrix<T> load_compressed_matrix(const std::string& path)
+{
+  return TCompressedMatrixReader<T>(path).read();
+}
+#endif
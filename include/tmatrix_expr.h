@@ -0,0 +1,600 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Шаблоны выражений для поэлементных операций над векторами и матрицами
+//
+// a + b - c * 2 не вычисляется сразу, а строит дерево узлов; при
+// присваивании в TDynamicVector/TDynamicMatrix дерево вычисляется за один
+// проход в буфер приёмника без промежуточных временных объектов.
+// Контейнеры хранятся в узлах по ссылке, поэтому выражение нельзя
+// сохранять (например, в auto) дольше жизни его операндов.
+
+#ifndef __TMATRIX_EXPR_H__
+#define __TMATRIX_EXPR_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "tmatrix_charconv.h"
+#include "tmatrix_kernels.h"
+#include "tmatrix_memory.h"
+#include "tmatrix_parallel.h"
+
+// распределитель по умолчанию задаётся здесь, в первом объявлении
+template<typename T, typename Alloc = tmatrix_detail::TAlignedAllocator<T>> class TDynamicVector;
+template<typename T> class TVectorView;
+template<typename T, typename Alloc = tmatrix_detail::TAlignedAllocator<T>> class TDynamicMatrix;
+template<typename T> class TMatrixView;
+
+// Базовые классы выражений (CRTP). Наследник E предоставляет
+// value_type, size() и eval(i) для векторов или rows(), cols() и
+// eval(i, j) для матриц; eval не проверяет индексы. aliases(p, bytes) сообщает, читает ли
+// выражение память [p, p + bytes) не поэлементно - тогда вычислять его
+// прямо в эту память нельзя.
+template<typename E>
+class TVecExpr
+{
+public:
+  const E& self() const noexcept { return static_cast<const E&>(*this); }
+};
+
+template<typename E>
+class TMatExpr
+{
+public:
+  const E& self() const noexcept { return static_cast<const E&>(*this); }
+};
+
+namespace tmatrix_detail
+{
+  // как узел хранит операнд: контейнеры - по ссылке, узлы и представления - по значению
+  template<typename E> struct TExprRef { typedef const E type; };
+  template<typename T, typename A> struct TExprRef<TDynamicVector<T, A>> { typedef const TDynamicVector<T, A>& type; };
+  template<typename T, typename A> struct TExprRef<TDynamicMatrix<T, A>> { typedef const TDynamicMatrix<T, A>& type; };
+
+  // операнд с непрерывным буфером data() (у матриц - строки с шагом
+  // stride()) - для него применимы SIMD-ядра
+  template<typename E> struct TContiguous : std::false_type {};
+  template<typename T, typename A> struct TContiguous<TDynamicVector<T, A>> : std::true_type {};
+  template<typename T> struct TContiguous<TVectorView<T>> : std::true_type {};
+  template<typename T, typename A> struct TContiguous<TDynamicMatrix<T, A>> : std::true_type {};
+  template<typename T> struct TContiguous<TMatrixView<T>> : std::true_type {};
+
+  struct TOpAdd
+  {
+    template<typename T>
+    static T apply(const T& a, const T& b) { return a + b; }
+  };
+  struct TOpSub
+  {
+    template<typename T>
+    static T apply(const T& a, const T& b) { return a - b; }
+  };
+  struct TOpMul
+  {
+    template<typename T>
+    static T apply(const T& a, const T& b) { return a * b; }
+  };
+
+  inline bool overlaps(const void* p1, size_t bytes1, const void* p2, size_t bytes2) noexcept
+  {
+    const uintptr_t b1 = reinterpret_cast<uintptr_t>(p1), b2 = reinterpret_cast<uintptr_t>(p2);
+    return b1 < b2 + bytes2 && b2 < b1 + bytes1;
+  }
+
+  // чтение представления [q, q + span) при записи в [p, p + bytes) - не
+  // поэлементное, если области пересекаются, но представление не совпадает
+  // с назначением: другое начало или другой шаг (тогда в записи того же
+  // вида, что у назначения, у него другая длина layout)
+  inline bool view_aliases(const void* p, size_t bytes, const void* q, size_t span, size_t layout) noexcept
+  {
+    return overlaps(p, bytes, q, span) && !((p == q) && (bytes == layout));
+  }
+}
+
+// Узел "вектор op вектор"
+template<typename Op, typename L, typename R>
+class TVecBinary : public TVecExpr<TVecBinary<Op, L, R>>
+{
+  typename tmatrix_detail::TExprRef<L>::type l;
+  typename tmatrix_detail::TExprRef<R>::type r;
+public:
+  typedef typename L::value_type value_type;
+
+  TVecBinary(const L& lhs, const R& rhs) : l(lhs), r(rhs)
+  {
+    if (l.size() != r.size())
+      throw std::invalid_argument("the length of the vectors must be the same");
+  }
+
+  size_t size() const noexcept { return l.size(); }
+  value_type eval(size_t i) const { return Op::apply(l.eval(i), r.eval(i)); }
+  bool aliases(const void* p, size_t bytes) const { return l.aliases(p, bytes) || r.aliases(p, bytes); }
+
+  const L& left() const noexcept { return l; }
+  const R& right() const noexcept { return r; }
+};
+
+// Узел "вектор op скаляр"
+template<typename Op, typename L>
+class TVecScalar : public TVecExpr<TVecScalar<Op, L>>
+{
+public:
+  typedef typename L::value_type value_type;
+private:
+  typename tmatrix_detail::TExprRef<L>::type l;
+  value_type s;
+public:
+  TVecScalar(const L& lhs, const value_type& val) : l(lhs), s(val) {}
+
+  size_t size() const noexcept { return l.size(); }
+  value_type eval(size_t i) const { return Op::apply(l.eval(i), s); }
+  bool aliases(const void* p, size_t bytes) const { return l.aliases(p, bytes); }
+
+  const L& left() const noexcept { return l; }
+  const value_type& scalar() const noexcept { return s; }
+};
+
+// Узел "матрица op матрица"
+template<typename Op, typename L, typename R>
+class TMatBinary : public TMatExpr<TMatBinary<Op, L, R>>
+{
+  typename tmatrix_detail::TExprRef<L>::type l;
+  typename tmatrix_detail::TExprRef<R>::type r;
+public:
+  typedef typename L::value_type value_type;
+
+  TMatBinary(const L& lhs, const R& rhs) : l(lhs), r(rhs)
+  {
+    if ((l.rows() != r.rows()) || (l.cols() != r.cols()))
+      throw std::invalid_argument("matrix's sizes should be the same");
+  }
+
+  size_t rows() const noexcept { return l.rows(); }
+  size_t cols() const noexcept { return l.cols(); }
+  value_type eval(size_t i, size_t j) const { return Op::apply(l.eval(i, j), r.eval(i, j)); }
+  bool aliases(const void* p, size_t bytes) const { return l.aliases(p, bytes) || r.aliases(p, bytes); }
+
+  const L& left() const noexcept { return l; }
+  const R& right() const noexcept { return r; }
+};
+
+// Узел "матрица op скаляр"
+template<typename Op, typename L>
+class TMatScalar : public TMatExpr<TMatScalar<Op, L>>
+{
+public:
+  typedef typename L::value_type value_type;
+private:
+  typename tmatrix_detail::TExprRef<L>::type l;
+  value_type s;
+public:
+  TMatScalar(const L& lhs, const value_type& val) : l(lhs), s(val) {}
+
+  size_t rows() const noexcept { return l.rows(); }
+  size_t cols() const noexcept { return l.cols(); }
+  value_type eval(size_t i, size_t j) const { return Op::apply(l.eval(i, j), s); }
+  bool aliases(const void* p, size_t bytes) const { return l.aliases(p, bytes); }
+
+  const L& left() const noexcept { return l; }
+  const value_type& scalar() const noexcept { return s; }
+};
+
+// Узел "матрица * вектор": i-й элемент - скалярное произведение i-й строки
+// на вектор. M и V - типы хранимых операндов (ссылка на контейнер или
+// вычисленный временный объект), оба с непрерывным data()
+template<typename M, typename V>
+class TMatVec : public TVecExpr<TMatVec<M, V>>
+{
+  M m;
+  V v;
+public:
+  typedef typename std::decay<M>::type::value_type value_type;
+
+  TMatVec(M mat, V vec) : m(static_cast<M&&>(mat)), v(static_cast<V&&>(vec))
+  {
+    if (m.cols() != v.size())
+      throw std::invalid_argument("the number of matrix columns must be equal to the length of the vector");
+  }
+
+  size_t size() const noexcept { return m.rows(); }
+  value_type eval(size_t i) const
+  {
+    return tmatrix_detail::vec_dot(m.data() + i * m.stride(), v.data(), m.cols());
+  }
+  bool aliases(const void* p, size_t bytes) const
+  {
+    return tmatrix_detail::overlaps(p, bytes, m.data(), m.rows() * m.stride() * sizeof(value_type))
+        || tmatrix_detail::overlaps(p, bytes, v.data(), v.size() * sizeof(value_type));
+  }
+
+  const typename std::decay<M>::type& matrix() const noexcept { return m; }
+  const typename std::decay<V>::type& vector() const noexcept { return v; }
+};
+
+// Узел "вектор * матрица" (x^T A): y[j] = сумма по i от x[i] * A[i][j].
+// При присваивании вычисляется по строкам A (mat_axpy4), eval(j) -
+// проход по столбцу для использования внутри других выражений
+template<typename V, typename M>
+class TVecMat : public TVecExpr<TVecMat<V, M>>
+{
+  V v;
+  M m;
+public:
+  typedef typename std::decay<M>::type::value_type value_type;
+
+  TVecMat(V vec, M mat) : v(static_cast<V&&>(vec)), m(static_cast<M&&>(mat))
+  {
+    if (v.size() != m.rows())
+      throw std::invalid_argument("the length of the vector must be equal to the number of matrix rows");
+  }
+
+  size_t size() const noexcept { return m.cols(); }
+  value_type eval(size_t j) const
+  {
+    value_type sum = value_type();
+    for (size_t i = 0; i < m.rows(); i++)
+      sum += v.data()[i] * m.data()[i * m.stride() + j];
+    return sum;
+  }
+  bool aliases(const void* p, size_t bytes) const
+  {
+    return tmatrix_detail::overlaps(p, bytes, m.data(), m.rows() * m.stride() * sizeof(value_type))
+        || tmatrix_detail::overlaps(p, bytes, v.data(), v.size() * sizeof(value_type));
+  }
+
+  const typename std::decay<M>::type& matrix() const noexcept { return m; }
+  const typename std::decay<V>::type& vector() const noexcept { return v; }
+};
+
+namespace tmatrix_detail
+{
+  // вычисление векторного выражения в непрерывный буфер dst[0..e.size())
+  template<typename T, typename E>
+  void expr_assign(T* dst, const TVecExpr<E>& expr)
+  {
+    const E& e = expr.self();
+    const size_t n = e.size();
+    for (size_t i = 0; i < n; i++)
+      dst[i] = e.eval(i);
+  }
+
+  // a + b и a - b над непрерывными операндами - готовые SIMD-ядра
+  template<typename T, typename Op, typename L, typename R>
+  void expr_assign(T* dst, const TVecBinary<Op, L, R>& e)
+  {
+    if constexpr (TContiguous<L>::value && TContiguous<R>::value && std::is_same<Op, TOpAdd>::value)
+      vec_add(e.left().data(), e.right().data(), dst, e.size());
+    else if constexpr (TContiguous<L>::value && TContiguous<R>::value && std::is_same<Op, TOpSub>::value)
+      vec_sub(e.left().data(), e.right().data(), dst, e.size());
+    else
+      expr_assign(dst, static_cast<const TVecExpr<TVecBinary<Op, L, R>>&>(e));
+  }
+
+  // a * s над непрерывным операндом - SIMD-ядро
+  template<typename T, typename Op, typename L>
+  void expr_assign(T* dst, const TVecScalar<Op, L>& e)
+  {
+    if constexpr (TContiguous<L>::value && std::is_same<Op, TOpMul>::value)
+      vec_scale(e.left().data(), e.scalar(), dst, e.size());
+    else
+      expr_assign(dst, static_cast<const TVecExpr<TVecScalar<Op, L>>&>(e));
+  }
+
+  // dst[i] = dst[i] op e[i] - составное присваивание без временного объекта
+  template<typename Op, typename T, typename E>
+  void expr_update(T* dst, const TVecExpr<E>& expr)
+  {
+    const E& e = expr.self();
+    const size_t n = e.size();
+    if constexpr (TContiguous<E>::value && std::is_same<Op, TOpAdd>::value)
+      vec_add(dst, e.data(), dst, n);
+    else if constexpr (TContiguous<E>::value && std::is_same<Op, TOpSub>::value)
+      vec_sub(dst, e.data(), dst, n);
+    else
+      for (size_t i = 0; i < n; i++)
+        dst[i] = Op::apply(dst[i], e.eval(i));
+  }
+
+  // y = A * x и y op= A * x: строки распределяются по пулу потоков,
+  // внутри блока строк - по четыре за проход по x (mat_dot4);
+  // Op = void - простое присваивание
+  template<typename Op, typename T, typename M, typename V>
+  void gemv_rows(T* dst, const TMatVec<M, V>& e, size_t r0, size_t r1)
+  {
+    const T* a = e.matrix().data();
+    const T* x = e.vector().data();
+    const size_t ld = e.matrix().stride(), n = e.matrix().cols();
+    size_t i = r0;
+    for (; i + 4 <= r1; i += 4) {
+      T y[4];
+      mat_dot4(a + i * ld, ld, x, n, y);
+      for (size_t r = 0; r < 4; r++)
+        if constexpr (std::is_same<Op, void>::value)
+          dst[i + r] = y[r];
+        else
+          dst[i + r] = Op::apply(dst[i + r], y[r]);
+    }
+    for (; i < r1; i++)
+      if constexpr (std::is_same<Op, void>::value)
+        dst[i] = e.eval(i);
+      else
+        dst[i] = Op::apply(dst[i], e.eval(i));
+  }
+
+  template<typename T, typename M, typename V>
+  void expr_assign(T* dst, const TMatVec<M, V>& e)
+  {
+    TThreadPool::instance().parallel_for(e.size(), e.vector().size(), [&](size_t r0, size_t r1) {
+      gemv_rows<void>(dst, e, r0, r1);
+    });
+  }
+
+  template<typename Op, typename T, typename M, typename V>
+  void expr_update(T* dst, const TMatVec<M, V>& e)
+  {
+    TThreadPool::instance().parallel_for(e.size(), e.vector().size(), [&](size_t r0, size_t r1) {
+      gemv_rows<Op>(dst, e, r0, r1);
+    });
+  }
+
+  // y = x^T A и y op= x^T A: y делится на полосы столбцов по пулу потоков,
+  // каждая полоса накапливается проходом по строкам A (по четыре строки
+  // за раз, mat_axpy4), так что A читается построчно и непрерывно
+  const size_t GEMV_COLUMN_BLOCK = 1024;
+
+  template<typename T, typename V, typename M>
+  void gemv_transposed(T* dst, const TVecMat<V, M>& e, bool negate, bool clear)
+  {
+    const T* a = e.matrix().data();
+    const T* x = e.vector().data();
+    const size_t ld = e.matrix().stride(), k = e.matrix().rows(), n = e.size();
+    const size_t nBlocks = (n + GEMV_COLUMN_BLOCK - 1) / GEMV_COLUMN_BLOCK;
+    TThreadPool::instance().parallel_for(nBlocks, k * GEMV_COLUMN_BLOCK, [&](size_t b0, size_t b1) {
+      const size_t c0 = b0 * GEMV_COLUMN_BLOCK, c1 = std::min(n, b1 * GEMV_COLUMN_BLOCK);
+      if (clear)
+        std::fill(dst + c0, dst + c1, T());
+      size_t i = 0;
+      for (; i + 4 <= k; i += 4) {
+        const T c[4] = { negate ? T() - x[i] : x[i], negate ? T() - x[i + 1] : x[i + 1],
+                         negate ? T() - x[i + 2] : x[i + 2], negate ? T() - x[i + 3] : x[i + 3] };
+        mat_axpy4(a + i * ld + c0, ld, c, dst + c0, c1 - c0);
+      }
+      // оставшиеся строки - тем же ядром с нулевыми коэффициентами
+      for (; i < k; i++) {
+        const T c[4] = { negate ? T() - x[i] : x[i], T(), T(), T() };
+        mat_axpy4(a + i * ld + c0, size_t(0), c, dst + c0, c1 - c0);
+      }
+    });
+  }
+
+  template<typename T, typename V, typename M>
+  void expr_assign(T* dst, const TVecMat<V, M>& e)
+  {
+    gemv_transposed(dst, e, false, true);
+  }
+
+  template<typename Op, typename T, typename V, typename M>
+  void expr_update(T* dst, const TVecMat<V, M>& e)
+  {
+    static_assert(std::is_same<Op, TOpAdd>::value || std::is_same<Op, TOpSub>::value, "unsupported operation");
+    gemv_transposed(dst, e, std::is_same<Op, TOpSub>::value, false);
+  }
+
+  // вызывает f(i, cnt) для строк [r0, r1) по одной (cnt = n); если ни у
+  // одного буфера нет дополнения строк (dense), весь диапазон
+  // обрабатывается одним вызовом f(r0, (r1 - r0) * n)
+  template<typename F>
+  void for_row_blocks(size_t n, size_t r0, size_t r1, bool dense, const F& f)
+  {
+    if (dense)
+      f(r0, (r1 - r0) * n);
+    else
+      for (size_t i = r0; i < r1; i++)
+        f(i, n);
+  }
+
+  // строки [r0, r1) матричного выражения в буфер с шагом строки ld
+  template<typename T, typename E>
+  void expr_assign_rows(T* dst, size_t ld, const TMatExpr<E>& expr, size_t r0, size_t r1)
+  {
+    const E& e = expr.self();
+    const size_t n = e.cols();
+    for (size_t i = r0; i < r1; i++) {
+      T* row = dst + i * ld;
+      for (size_t j = 0; j < n; j++)
+        row[j] = e.eval(i, j);
+    }
+  }
+
+  template<typename T, typename Op, typename L, typename R>
+  void expr_assign_rows(T* dst, size_t ld, const TMatBinary<Op, L, R>& e, size_t r0, size_t r1)
+  {
+    if constexpr (TContiguous<L>::value && TContiguous<R>::value
+                  && (std::is_same<Op, TOpAdd>::value || std::is_same<Op, TOpSub>::value)) {
+      const L& l = e.left();
+      const R& r = e.right();
+      const size_t n = e.cols();
+      for_row_blocks(n, r0, r1, l.stride() == n && r.stride() == n && ld == n, [&](size_t i, size_t cnt) {
+        if constexpr (std::is_same<Op, TOpAdd>::value)
+          vec_add(l.data() + i * l.stride(), r.data() + i * r.stride(), dst + i * ld, cnt);
+        else
+          vec_sub(l.data() + i * l.stride(), r.data() + i * r.stride(), dst + i * ld, cnt);
+      });
+    }
+    else
+      expr_assign_rows(dst, ld, static_cast<const TMatExpr<TMatBinary<Op, L, R>>&>(e), r0, r1);
+  }
+
+  template<typename T, typename Op, typename L>
+  void expr_assign_rows(T* dst, size_t ld, const TMatScalar<Op, L>& e, size_t r0, size_t r1)
+  {
+    if constexpr (TContiguous<L>::value && std::is_same<Op, TOpMul>::value) {
+      const L& l = e.left();
+      const size_t n = e.cols();
+      for_row_blocks(n, r0, r1, l.stride() == n && ld == n, [&](size_t i, size_t cnt) {
+        vec_scale(l.data() + i * l.stride(), e.scalar(), dst + i * ld, cnt);
+      });
+    }
+    else
+      expr_assign_rows(dst, ld, static_cast<const TMatExpr<TMatScalar<Op, L>>&>(e), r0, r1);
+  }
+
+  template<typename Op, typename T, typename E>
+  void expr_update_rows(T* dst, size_t ld, const E& e, size_t r0, size_t r1)
+  {
+    const size_t n = e.cols();
+    if constexpr (TContiguous<E>::value && (std::is_same<Op, TOpAdd>::value || std::is_same<Op, TOpSub>::value)) {
+      for_row_blocks(n, r0, r1, e.stride() == n && ld == n, [&](size_t i, size_t cnt) {
+        if constexpr (std::is_same<Op, TOpAdd>::value)
+          vec_add(dst + i * ld, e.data() + i * e.stride(), dst + i * ld, cnt);
+        else
+          vec_sub(dst + i * ld, e.data() + i * e.stride(), dst + i * ld, cnt);
+      });
+    }
+    else
+      for (size_t i = r0; i < r1; i++) {
+        T* row = dst + i * ld;
+        for (size_t j = 0; j < n; j++)
+          row[j] = Op::apply(row[j], e.eval(i, j));
+      }
+  }
+
+  // матричные выражения вычисляются по блокам строк в пуле потоков
+  template<typename T, typename E>
+  void expr_assign(T* dst, size_t ld, const TMatExpr<E>& expr)
+  {
+    const E& e = expr.self();
+    TThreadPool::instance().parallel_for(e.rows(), e.cols(), [&](size_t r0, size_t r1) {
+      expr_assign_rows(dst, ld, e, r0, r1);
+    });
+  }
+
+  template<typename Op, typename T, typename E>
+  void expr_update(T* dst, size_t ld, const TMatExpr<E>& expr)
+  {
+    const E& e = expr.self();
+    TThreadPool::instance().parallel_for(e.rows(), e.cols(), [&](size_t r0, size_t r1) {
+      expr_update_rows<Op>(dst, ld, e, r0, r1);
+    });
+  }
+}
+
+// векторные операции
+template<typename L, typename R>
+TVecBinary<tmatrix_detail::TOpAdd, L, R> operator+(const TVecExpr<L>& l, const TVecExpr<R>& r)
+{
+  return TVecBinary<tmatrix_detail::TOpAdd, L, R>(l.self(), r.self());
+}
+template<typename L, typename R>
+TVecBinary<tmatrix_detail::TOpSub, L, R> operator-(const TVecExpr<L>& l, const TVecExpr<R>& r)
+{
+  return TVecBinary<tmatrix_detail::TOpSub, L, R>(l.self(), r.self());
+}
+
+// скалярные операции
+template<typename L>
+TVecScalar<tmatrix_detail::TOpAdd, L> operator+(const TVecExpr<L>& l, const typename L::value_type& val)
+{
+  return TVecScalar<tmatrix_detail::TOpAdd, L>(l.self(), val);
+}
+template<typename L>
+TVecScalar<tmatrix_detail::TOpSub, L> operator-(const TVecExpr<L>& l, const typename L::value_type& val)
+{
+  return TVecScalar<tmatrix_detail::TOpSub, L>(l.self(), val);
+}
+template<typename L>
+TVecScalar<tmatrix_detail::TOpMul, L> operator*(const TVecExpr<L>& l, const typename L::value_type& val)
+{
+  return TVecScalar<tmatrix_detail::TOpMul, L>(l.self(), val);
+}
+
+// матрично-матричные операции
+template<typename L, typename R>
+TMatBinary<tmatrix_detail::TOpAdd, L, R> operator+(const TMatExpr<L>& l, const TMatExpr<R>& r)
+{
+  return TMatBinary<tmatrix_detail::TOpAdd, L, R>(l.self(), r.self());
+}
+template<typename L, typename R>
+TMatBinary<tmatrix_detail::TOpSub, L, R> operator-(const TMatExpr<L>& l, const TMatExpr<R>& r)
+{
+  return TMatBinary<tmatrix_detail::TOpSub, L, R>(l.self(), r.self());
+}
+
+// матрично-скалярные операции
+template<typename L>
+TMatScalar<tmatrix_detail::TOpMul, L> operator*(const TMatExpr<L>& l, const typename L::value_type& val)
+{
+  return TMatScalar<tmatrix_detail::TOpMul, L>(l.self(), val);
+}
+
+// сравнение (в том числе контейнеров между собой)
+template<typename L, typename R>
+bool operator==(const TVecExpr<L>& lhs, const TVecExpr<R>& rhs)
+{
+  const L& l = lhs.self();
+  const R& r = rhs.self();
+  if (l.size() != r.size())
+    return false;
+  for (size_t i = 0; i < l.size(); i++)
+    if (l.eval(i) != r.eval(i))
+      return false;
+  return true;
+}
+template<typename L, typename R>
+bool operator!=(const TVecExpr<L>& lhs, const TVecExpr<R>& rhs)
+{
+  return !(lhs == rhs);
+}
+template<typename L, typename R>
+bool operator==(const TMatExpr<L>& lhs, const TMatExpr<R>& rhs)
+{
+  const L& l = lhs.self();
+  const R& r = rhs.self();
+  if ((l.rows() != r.rows()) || (l.cols() != r.cols()))
+    return false;
+  for (size_t i = 0; i < l.rows(); i++)
+    for (size_t j = 0; j < l.cols(); j++)
+      if (l.eval(i, j) != r.eval(i, j))
+        return false;
+  return true;
+}
+template<typename L, typename R>
+bool operator!=(const TMatExpr<L>& lhs, const TMatExpr<R>& rhs)
+{
+  return !(lhs == rhs);
+}
+
+// вывод невычисленного выражения в том же формате, что и у контейнеров
+template<typename E>
+std::ostream& operator<<(std::ostream& ostr, const TVecExpr<E>& expr)
+{
+  const E& e = expr.self();
+  tmatrix_detail::TTextWriter w(ostr);
+  for (size_t i = 0; i < e.size() && w; i++) {
+    w.value(e.eval(i));
+    w.put(w.delimiter());
+  }
+  return ostr;
+}
+template<typename E>
+std::ostream& operator<<(std::ostream& ostr, const TMatExpr<E>& expr)
+{
+  const E& e = expr.self();
+  tmatrix_detail::TTextWriter w(ostr);
+  for (size_t i = 0; i < e.rows() && w; i++) {
+    for (size_t j = 0; j < e.cols(); j++) {
+      if (j != 0)
+        w.put(w.delimiter());
+      w.value(e.eval(i, j));
+    }
+    w.put('\n');
+  }
+  return ostr;
+}
+#endif
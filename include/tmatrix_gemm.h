@@ -0,0 +1,159 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Блочное умножение матриц (GEMM): C += A * B
+//
+// Схема Гото: B режется на панели NC x KC (уровень L3), A - на блоки
+// MC x KC (уровень L2); блоки упаковываются в непрерывные буферы полосами
+// по MR строк и NR столбцов, а микроядро держит блок MR x NR результата
+// в регистрах на всей длине KC. Блоки A обрабатываются параллельно
+// в пуле потоков, панель B у всех общая.
+
+#ifndef __TMATRIX_GEMM_H__
+#define __TMATRIX_GEMM_H__
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+#include "tmatrix_kernels.h"
+#include "tmatrix_memory.h"
+#include "tmatrix_parallel.h"
+
+namespace tmatrix_detail
+{
+  // параметры разбиения на блоки
+  template<typename T>
+  struct TGemmBlocking
+  {
+    static constexpr size_t NR = TGemmTile<T>::NR; // столбцов в микроядре
+    static constexpr size_t MR = TGemmTile<T>::MR; // строк в микроядре
+    static constexpr size_t KC = 256;              // глубина панели (L1)
+    static constexpr size_t MC = 20 * MR;          // строк блока A (L2)
+    static constexpr size_t NC = 128 * NR;         // столбцов панели B (L3)
+  };
+
+  // упаковка блока A[mc x kc] полосами по MR строк: внутри полосы для каждого p подряд идут MR элементов
+  template<typename T>
+  void gemm_pack_a(size_t mc, size_t kc, const T* a, size_t lda, T* buf)
+  {
+    const size_t MR = TGemmBlocking<T>::MR;
+    for (size_t i = 0; i < mc; i += MR) {
+      const size_t mr = std::min(MR, mc - i);
+      for (size_t p = 0; p < kc; p++) {
+        for (size_t r = 0; r < mr; r++)
+          buf[r] = a[(i + r) * lda + p];
+        for (size_t r = mr; r < MR; r++)
+          buf[r] = T();
+        buf += MR;
+      }
+    }
+  }
+
+  // упаковка панели B[kc x nc] полосами по NR столбцов: для каждого p подряд идут NR элементов
+  template<typename T>
+  void gemm_pack_b(size_t kc, size_t nc, const T* b, size_t ldb, T* buf)
+  {
+    const size_t NR = TGemmBlocking<T>::NR;
+    for (size_t j = 0; j < nc; j += NR) {
+      const size_t nr = std::min(NR, nc - j);
+      for (size_t p = 0; p < kc; p++) {
+        const T* src = b + p * ldb + j;
+        for (size_t c = 0; c < nr; c++)
+          buf[c] = src[c];
+        for (size_t c = nr; c < NR; c++)
+          buf[c] = T();
+        buf += NR;
+      }
+    }
+  }
+
+  // микроядро: C[mr x nr] += A-полоса * B-полоса; для float, double,
+  // int32_t и int64_t - SIMD-ядро выбранного набора инструкций
+  template<typename T>
+  void gemm_micro(size_t kc, const T* a, const T* b, T* c, size_t ldc, size_t mr, size_t nr)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>()) {
+      k->gemm_micro(kc, a, b, c, ldc, mr, nr);
+      return;
+    }
+    const size_t MR = TGemmBlocking<T>::MR;
+    const size_t NR = TGemmBlocking<T>::NR;
+    T acc[MR][NR] = {};
+    for (size_t p = 0; p < kc; p++) {
+      for (size_t i = 0; i < MR; i++) {
+        const T ai = a[i];
+        for (size_t j = 0; j < NR; j++)
+          acc[i][j] += ai * b[j];
+      }
+      a += MR;
+      b += NR;
+    }
+    for (size_t i = 0; i < mr; i++)
+      for (size_t j = 0; j < nr; j++)
+        c[i * ldc + j] += acc[i][j];
+  }
+
+  // простой проход i-k-j для маленьких задач и неарифметических типов
+  template<typename T>
+  void gemm_naive(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+  {
+    for (size_t i = 0; i < m; i++)
+      for (size_t p = 0; p < k; p++) {
+        const T aip = a[i * lda + p];
+        const T* brow = b + p * ldb;
+        T* crow = c + i * ldc;
+        for (size_t j = 0; j < n; j++)
+          crow[j] += aip * brow[j];
+      }
+  }
+
+  // C[m x n] += A[m x k] * B[k x n], все матрицы хранятся построчно с шагами lda, ldb, ldc
+  template<typename T>
+  void gemm(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc)
+  {
+    typedef TGemmBlocking<T> B;
+    if (!std::is_arithmetic<T>::value || m * n * k <= 32 * 32 * 32) {
+      gemm_naive(m, n, k, a, lda, b, ldb, c, ldc);
+      return;
+    }
+
+    // блоки A делятся между потоками пула; при большом числе потоков
+    // блок уменьшается, чтобы работы хватило всем
+    const size_t nThreads = TThreadPool::instance().num_threads();
+    const size_t mcPerThread = ((m + nThreads - 1) / nThreads + B::MR - 1) / B::MR * B::MR;
+    const size_t mcStep = std::min(B::MC, mcPerThread);
+    const size_t nBlocks = (m + mcStep - 1) / mcStep;
+
+    const size_t kcMax = std::min(B::KC, k);
+    const size_t ncMax = std::min((n + B::NR - 1) / B::NR * B::NR, B::NC);
+    TArrayBuffer<T> packB(ncMax * kcMax);
+    T* bufB = packB.get();
+
+    for (size_t jc = 0; jc < n; jc += B::NC) {
+      const size_t nc = std::min(B::NC, n - jc);
+      for (size_t pc = 0; pc < k; pc += B::KC) {
+        const size_t kc = std::min(B::KC, k - pc);
+        gemm_pack_b(kc, nc, b + pc * ldb + jc, ldb, bufB);
+        TThreadPool::instance().parallel_for(nBlocks, mcStep * kc * nc, [&](size_t b0, size_t b1) {
+          TArrayBuffer<T> packA(mcStep * kc);
+          T* bufA = packA.get();
+          for (size_t blk = b0; blk < b1; blk++) {
+            const size_t ic = blk * mcStep;
+            const size_t mc = std::min(mcStep, m - ic);
+            gemm_pack_a(mc, kc, a + ic * lda + pc, lda, bufA);
+            for (size_t jr = 0; jr < nc; jr += B::NR) {
+              const size_t nr = std::min(B::NR, nc - jr);
+              for (size_t ir = 0; ir < mc; ir += B::MR) {
+                const size_t mr = std::min(B::MR, mc - ir);
+                gemm_micro(kc, bufA + ir * kc, bufB + jr * kc, c + (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+              }
+            }
+          }
+        });
+      }
+    }
+  }
+}
+#endif
@@ -0,0 +1,151 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Векторные ядра (SIMD) с выбором набора инструкций во время выполнения
+//
+// Для float, double, int32_t и int64_t при первом обращении по CPUID
+// выбирается лучшая из доступных реализаций (AVX-512, AVX2, SSE2);
+// для прочих типов используются обычные циклы. Выбор можно
+// переопределить переменной окружения TMATRIX_SIMD=scalar|sse2|avx2|avx512.
+
+#ifndef __TMATRIX_KERNELS_H__
+#define __TMATRIX_KERNELS_H__
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tmatrix_detail
+{
+  enum TSimdLevel
+  {
+    SIMD_SCALAR,
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_AVX512
+  };
+
+  // блок результата, который микроядро GEMM держит в регистрах:
+  // MR строк на NR столбцов (одна строка кэша)
+  template<typename T>
+  struct TGemmTile
+  {
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = sizeof(T) >= 64 ? 1 : 64 / sizeof(T);
+  };
+
+  // таблица ядер для элементов типа T
+  template<typename T>
+  struct TVectorKernels
+  {
+    void (*add)(const T* a, const T* b, T* c, size_t n);   // c = a + b
+    void (*sub)(const T* a, const T* b, T* c, size_t n);   // c = a - b
+    void (*scale)(const T* a, T s, T* c, size_t n);        // c = a * s
+    T (*dot)(const T* a, const T* b, size_t n);            // (a, b)
+    // y[r] = (a + r * lda, x), r = 0..3: четыре строки матрицы за один проход по x
+    void (*dot4)(const T* a, size_t lda, const T* x, size_t n, T* y);
+    // y += x[0] * a + x[1] * (a + lda) + x[2] * (a + 2 * lda) + x[3] * (a + 3 * lda)
+    void (*axpy4)(const T* a, size_t lda, const T* x, T* y, size_t n);
+    // блок 8 x 8: b[j * ldb + i] = a[i * lda + j]
+    void (*transpose8)(const T* a, size_t lda, T* b, size_t ldb);
+    // микроядро GEMM: C[mr x nr] += A-полоса * B-полоса; полосы упакованы
+    // по MR и NR элементов (TGemmTile) на каждый из kc шагов
+    void (*gemm_micro)(size_t kc, const T* a, const T* b, T* c, size_t ldc, size_t mr, size_t nr);
+  };
+
+  // набор инструкций, выбранный для процесса
+  TSimdLevel simd_level();
+  const char* simd_level_name(TSimdLevel level);
+
+  // таблица для типа T; nullptr - векторной реализации нет
+  template<typename T>
+  inline const TVectorKernels<T>* vector_kernels() { return nullptr; }
+
+  template<> const TVectorKernels<float>* vector_kernels<float>();
+  template<> const TVectorKernels<double>* vector_kernels<double>();
+  template<> const TVectorKernels<int32_t>* vector_kernels<int32_t>();
+  template<> const TVectorKernels<int64_t>* vector_kernels<int64_t>();
+
+  template<typename T>
+  void vec_add(const T* a, const T* b, T* c, size_t n)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>()) {
+      k->add(a, b, c, n);
+      return;
+    }
+    for (size_t i = 0; i < n; i++)
+      c[i] = a[i] + b[i];
+  }
+
+  template<typename T>
+  void vec_sub(const T* a, const T* b, T* c, size_t n)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>()) {
+      k->sub(a, b, c, n);
+      return;
+    }
+    for (size_t i = 0; i < n; i++)
+      c[i] = a[i] - b[i];
+  }
+
+  template<typename T>
+  void vec_scale(const T* a, const T& s, T* c, size_t n)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>()) {
+      k->scale(a, s, c, n);
+      return;
+    }
+    for (size_t i = 0; i < n; i++)
+      c[i] = a[i] * s;
+  }
+
+  template<typename T>
+  T vec_dot(const T* a, const T* b, size_t n)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>())
+      return k->dot(a, b, n);
+    T sum = T();
+    for (size_t i = 0; i < n; i++)
+      sum += a[i] * b[i];
+    return sum;
+  }
+
+  template<typename T>
+  void mat_dot4(const T* a, size_t lda, const T* x, size_t n, T* y)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>()) {
+      k->dot4(a, lda, x, n, y);
+      return;
+    }
+    for (size_t r = 0; r < 4; r++) {
+      T sum = T();
+      for (size_t i = 0; i < n; i++)
+        sum += a[r * lda + i] * x[i];
+      y[r] = sum;
+    }
+  }
+
+  template<typename T>
+  void mat_axpy4(const T* a, size_t lda, const T* x, T* y, size_t n)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>()) {
+      k->axpy4(a, lda, x, y, n);
+      return;
+    }
+    for (size_t i = 0; i < n; i++)
+      y[i] += x[0] * a[i] + x[1] * a[lda + i] + x[2] * a[2 * lda + i] + x[3] * a[3 * lda + i];
+  }
+
+  template<typename T>
+  void mat_transpose8(const T* a, size_t lda, T* b, size_t ldb)
+  {
+    if (const TVectorKernels<T>* k = vector_kernels<T>()) {
+      k->transpose8(a, lda, b, ldb);
+      return;
+    }
+    for (size_t i = 0; i < 8; i++)
+      for (size_t j = 0; j < 8; j++)
+        b[j * ldb + i] = a[i * lda + j];
+  }
+}
+#endif
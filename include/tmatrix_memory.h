@@ -0,0 +1,297 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Выделение выровненной памяти под буферы векторов и матриц
+
+#ifndef __TMATRIX_MEMORY_H__
+#define __TMATRIX_MEMORY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Теги конструкторов векторов и матриц:
+//   uninitialized_init - память не заполняется (только для типов с
+//                        тривиальным конструктором по умолчанию);
+//   zero_init          - элементы равны T(); у распределителя по умолчанию
+//                        память арифметических типов берётся из calloc,
+//                        и большие буферы получают обнулённые ОС страницы
+//                        без отдельного прохода по памяти;
+//   fill_init          - все элементы равны заданному значению
+struct TUninitializedInit { explicit TUninitializedInit() = default; };
+struct TZeroInit { explicit TZeroInit() = default; };
+struct TFillInit { explicit TFillInit() = default; };
+
+inline constexpr TUninitializedInit uninitialized_init{};
+inline constexpr TZeroInit zero_init{};
+inline constexpr TFillInit fill_init{};
+
+// Тег конструктора, принимающего чужой буфер без копирования: вектор или
+// матрица владеет им и при разрушении вызывает переданный deleter(p)
+struct TAdoptBuffer { explicit TAdoptBuffer() = default; };
+inline constexpr TAdoptBuffer adopt_buffer{};
+
+// Пул буферов: освобождённая память векторов и матриц (распределитель по
+// умолчанию) не возвращается системе, а кэшируется по классам размеров -
+// в кэше своего потока и в общем для процесса списке, - и повторно
+// выдаётся следующим временным объектам того же размера. Буферы крупнее
+// 256 Мбайт не кэшируются; кэш потока держит не более 64 Мбайт, общий
+// список - не более 256 Мбайт, остальное сразу возвращается системе.
+// TMATRIX_POOL=0 в окружении выключает пул
+class TBufferPool
+{
+public:
+  static void set_enabled(bool on) noexcept;
+  static bool is_enabled() noexcept;
+  // возвращает системе буферы из общего списка и из кэша текущего потока
+  static void trim() noexcept;
+  // число обращений к malloc/calloc за всё время (для диагностики)
+  static size_t system_allocations() noexcept;
+  // байтов в общем списке и в кэше текущего потока
+  static size_t retained_bytes() noexcept;
+};
+
+namespace tmatrix_detail
+{
+  // выравнивание буферов - по строке кэша
+  const size_t MEM_ALIGN = 64;
+
+  template<typename T>
+  constexpr size_t array_align()
+  {
+    return alignof(T) > MEM_ALIGN ? alignof(T) : MEM_ALIGN;
+  }
+
+  // выровненный блок из malloc/calloc; исходный указатель хранится
+  // непосредственно перед выровненным адресом
+  inline void* aligned_block(size_t bytes, size_t align, bool zero)
+  {
+    const size_t extra = align - 1 + sizeof(void*);
+    if (bytes > SIZE_MAX - extra)
+      throw std::bad_alloc();
+    void* raw = zero ? std::calloc(bytes + extra, 1) : std::malloc(bytes + extra);
+    if (raw == nullptr)
+      throw std::bad_alloc();
+    const uintptr_t p = (reinterpret_cast<uintptr_t>(raw) + extra) & ~uintptr_t(align - 1);
+    reinterpret_cast<void**>(p)[-1] = raw;
+    return reinterpret_cast<void*>(p);
+  }
+
+  inline void free_aligned_block(void* p) noexcept
+  {
+    if (p != nullptr)
+      std::free(static_cast<void**>(p)[-1]);
+  }
+
+  // буфер не меньше bytes, выровненный на MEM_ALIGN, из пула (tmatrix_pool.cpp)
+  void* pool_allocate(size_t bytes, bool zero);
+  void pool_free(void* p, size_t bytes) noexcept;
+
+  // Распределитель по умолчанию для векторов и матриц: как std::allocator,
+  // но память выровнена на MEM_ALIGN и берётся из пула буферов (типы с
+  // большим выравниванием - напрямую из malloc). Пользовательский
+  // распределитель (арена, huge pages, NUMA) подставляется параметром
+  // шаблона Alloc
+  template<typename T>
+  class TAlignedAllocator
+  {
+  public:
+    typedef T value_type;
+    typedef std::true_type is_always_equal;
+
+    TAlignedAllocator() noexcept {}
+    template<typename U>
+    TAlignedAllocator(const TAlignedAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) { return allocate(n, false); }
+    // обнулённая память (calloc или очищенный буфер из пула);
+    // распределитель может не иметь этого метода
+    T* allocate_zeroed(size_t n) { return allocate(n, true); }
+    void deallocate(T* p, size_t n) noexcept
+    {
+      if (array_align<T>() == MEM_ALIGN)
+        pool_free(p, n * sizeof(T));
+      else
+        free_aligned_block(p);
+    }
+
+    template<typename U>
+    bool operator==(const TAlignedAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const TAlignedAllocator<U>&) const noexcept { return false; }
+
+  private:
+    T* allocate(size_t n, bool zero)
+    {
+      if (n > SIZE_MAX / sizeof(T))
+        throw std::bad_alloc();
+      if (array_align<T>() == MEM_ALIGN)
+        return static_cast<T*>(pool_allocate(n * sizeof(T), zero));
+      return static_cast<T*>(aligned_block(n * sizeof(T), array_align<T>(), zero));
+    }
+  };
+
+  template<typename A, typename = void>
+  struct THasAllocateZeroed : std::false_type {};
+  template<typename A>
+  struct THasAllocateZeroed<A, std::void_t<decltype(std::declval<A&>().allocate_zeroed(size_t()))>> : std::true_type {};
+
+  // создаёт элементы p[0..n) из args; при исключении созданные уничтожаются,
+  // а память возвращается распределителю
+  template<typename A, typename T, typename... Args>
+  void construct_array(A& a, T* p, size_t n, const Args&... args)
+  {
+    typedef std::allocator_traits<A> traits;
+    size_t i = 0;
+    try {
+      for (; i < n; i++)
+        traits::construct(a, p + i, args...);
+    }
+    catch (...) {
+      while (i > 0)
+        traits::destroy(a, p + --i);
+      traits::deallocate(a, p, n);
+      throw;
+    }
+  }
+
+  // n элементов из распределителя a. Элементы с тривиальным конструктором
+  // по умолчанию не инициализируются (как у new T[n]), остальные
+  // создаются через allocator_traits::construct
+  template<typename A>
+  typename std::allocator_traits<A>::value_type* allocate_array(A& a, size_t n)
+  {
+    typedef std::allocator_traits<A> traits;
+    typedef typename traits::value_type T;
+    static_assert(std::is_same<typename traits::pointer, T*>::value, "allocator should use raw pointers");
+    T* p = traits::allocate(a, n);
+    if constexpr (!std::is_trivially_default_constructible<T>::value)
+      construct_array(a, p, n);
+    return p;
+  }
+
+  template<typename A>
+  typename std::allocator_traits<A>::value_type* allocate_array(A& a, size_t n, TUninitializedInit)
+  {
+    typedef typename std::allocator_traits<A>::value_type T;
+    static_assert(std::is_trivially_default_constructible<T>::value,
+      "uninitialized_init requires a trivially default constructible type");
+    return allocate_array(a, n);
+  }
+
+  template<typename A>
+  typename std::allocator_traits<A>::value_type* allocate_array(A& a, size_t n, TZeroInit)
+  {
+    typedef std::allocator_traits<A> traits;
+    typedef typename traits::value_type T;
+    static_assert(std::is_same<typename traits::pointer, T*>::value, "allocator should use raw pointers");
+    if constexpr (std::is_arithmetic<T>::value && THasAllocateZeroed<A>::value)
+      return a.allocate_zeroed(n);
+    T* p = traits::allocate(a, n);
+    construct_array(a, p, n); // value-инициализация: T()
+    return p;
+  }
+
+  template<typename A, typename T>
+  T* allocate_array(A& a, size_t n, TFillInit, const T& val)
+  {
+    typedef std::allocator_traits<A> traits;
+    static_assert(std::is_same<typename traits::value_type, T>::value, "allocator should match the element type");
+    static_assert(std::is_same<typename traits::pointer, T*>::value, "allocator should use raw pointers");
+    T* p = traits::allocate(a, n);
+    construct_array(a, p, n, val);
+    return p;
+  }
+
+  template<typename A, typename T>
+  void free_array(A& a, T* p, size_t n) noexcept
+  {
+    typedef std::allocator_traits<A> traits;
+    if (p == nullptr)
+      return;
+    if constexpr (!std::is_trivially_destructible<T>::value)
+      for (size_t i = 0; i < n; i++)
+        traits::destroy(a, p + i);
+    traits::deallocate(a, p, n);
+  }
+
+  // выровненные буферы без пользовательского распределителя
+  template<typename T>
+  T* allocate_array(size_t n)
+  {
+    TAlignedAllocator<T> a;
+    return allocate_array(a, n);
+  }
+
+  template<typename T>
+  void free_array(T* p, size_t n) noexcept
+  {
+    TAlignedAllocator<T> a;
+    free_array(a, p, n);
+  }
+
+  // шаг строки матрицы (в элементах): строки от 4 строк кэша дополняются
+  // до целого числа строк кэша, чтобы каждая начиналась с выровненного
+  // адреса; короткие строки не дополняются, чтобы не раздувать память
+  template<typename T>
+  constexpr size_t row_stride(size_t cols)
+  {
+    if (MEM_ALIGN % sizeof(T) != 0 || cols * sizeof(T) < 4 * MEM_ALIGN)
+      return cols;
+    const size_t perLine = MEM_ALIGN / sizeof(T);
+    return (cols + perLine - 1) / perLine * perLine;
+  }
+
+  // владелец чужого буфера, принятого с adopt_buffer
+  template<typename T>
+  class TBufferOwner
+  {
+  public:
+    virtual ~TBufferOwner() {}
+    virtual void release(T* p) noexcept = 0;
+  };
+
+  template<typename T, typename D>
+  class TDeleterOwner : public TBufferOwner<T>
+  {
+    D deleter;
+  public:
+    explicit TDeleterOwner(D d) : deleter(std::move(d)) {}
+    void release(T* p) noexcept override { deleter(p); }
+  };
+
+  // владелец для p; если он не создан, буфер сразу освобождается,
+  // как это делает shared_ptr
+  template<typename T, typename D>
+  TBufferOwner<T>* adopt(T* p, D d)
+  {
+    try {
+      return new TDeleterOwner<T, D>(d);
+    }
+    catch (...) {
+      d(p);
+      throw;
+    }
+  }
+
+  // временный выровненный буфер, освобождаемый при выходе из области видимости
+  template<typename T>
+  class TArrayBuffer
+  {
+    T* p;
+    size_t n;
+  public:
+    explicit TArrayBuffer(size_t size) : p(allocate_array<T>(size)), n(size) {}
+    TArrayBuffer(const TArrayBuffer&) = delete;
+    TArrayBuffer& operator=(const TArrayBuffer&) = delete;
+    ~TArrayBuffer() { free_array(p, n); }
+
+    T* get() const noexcept { return p; }
+  };
+}
+#endif
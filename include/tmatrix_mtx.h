@@ -0,0 +1,266 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Чтение и запись матриц в формате Matrix Market (.mtx)
+//
+// Поддерживаются плотный (array) и координатный (coordinate) форматы с
+// полями real, integer и pattern и симметриями general, symmetric и
+// skew-symmetric; комплексные матрицы не поддерживаются. Координатная
+// матрица читается в плотную TDynamicMatrix: отсутствующие элементы -
+// нули, повторяющиеся элементы складываются, у симметричных матриц
+// заполняется и второй треугольник.
+// Данные (файл отображается в память целиком) делятся на куски по
+// границам строк, куски разбираются параллельно в пуле потоков.
+
+#ifndef __TMATRIX_MTX_H__
+#define __TMATRIX_MTX_H__
+
+#include <cstddef>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "tmatrix_text.h"
+
+// формат записи: плотный (все элементы по столбцам) или координатный
+// (только ненулевые элементы)
+enum TMtxFormat { MTX_ARRAY, MTX_COORDINATE };
+
+namespace tmatrix_detail
+{
+  enum TMtxField { MTX_REAL, MTX_INTEGER, MTX_PATTERN };
+  enum TMtxSymmetry { MTX_GENERAL, MTX_SYMMETRIC, MTX_SKEW };
+
+  struct TMtxHeader
+  {
+    TMtxFormat format;
+    TMtxField field;
+    TMtxSymmetry symmetry;
+    size_t rows, cols, entries; // entries - число записей (у array - элементов)
+    const char* data; // первая строка данных
+  };
+
+  // разбор строки-сигнатуры, комментариев и строки размеров
+  TMtxHeader parse_mtx_header(const char* first, const char* last);
+
+  // следующая строка данных (пустые строки и комментарии пропускаются)
+  inline bool next_mtx_line(const char*& pos, const char* last, const char*& line, const char*& eol)
+  {
+    while (next_text_line(pos, last, line, eol)) {
+      while (is_text_space(*line))
+        ++line;
+      if (*line != '%')
+        return true;
+    }
+    return false;
+  }
+
+  // запись "i j [value]" координатного формата; индексы - с нуля
+  template<typename T>
+  void parse_mtx_entry(const char* first, const char* last, const TMtxHeader& h,
+                       size_t& i, size_t& j, T& val, size_t entry)
+  {
+    const char* p = first;
+    bool ok = true;
+    auto number = [&](auto& x) {
+      while ((p != last) && is_text_space(*p))
+        ++p;
+      const char* e = parse_number(p, last, x);
+      if ((e == nullptr) || ((e != last) && !is_text_space(*e)))
+        ok = false;
+      else
+        p = e;
+    };
+    number(i);
+    if (ok)
+      number(j);
+    if (h.field == MTX_PATTERN)
+      val = T(1);
+    else if (ok)
+      number(val);
+    while (ok && (p != last) && is_text_space(*p))
+      ++p;
+    if (!ok || (p != last))
+      throw std::invalid_argument("cannot parse entry " + std::to_string(entry + 1));
+    if ((i == 0) || (i > h.rows) || (j == 0) || (j > h.cols))
+      throw std::out_of_range("entry " + std::to_string(entry + 1) + " is out of the bounds of matrix");
+    i--;
+    j--;
+  }
+
+  template<typename T>
+  TDynamicMatrix<T> parse_mtx_coordinate(const TMtxHeader& h, const char* last)
+  {
+    const std::vector<const char*> bounds = split_text(h.data, last, [](char c) { return c == '\n'; });
+    const size_t chunks = bounds.size() - 1;
+
+    // проход 1: число записей в каждом куске
+    std::vector<size_t> start(chunks + 1, 0);
+    TThreadPool::instance().parallel_for(chunks, TEXT_CHUNK_MIN, [&](size_t c0, size_t c1) {
+      for (size_t c = c0; c < c1; c++) {
+        const char* pos = bounds[c];
+        const char *line, *eol;
+        size_t n = 0;
+        while (next_mtx_line(pos, bounds[c + 1], line, eol))
+          n++;
+        start[c + 1] = n;
+      }
+    });
+    for (size_t c = 0; c < chunks; c++)
+      start[c + 1] += start[c];
+    if (start[chunks] != h.entries)
+      throw std::invalid_argument("the number of entries does not match the header");
+
+    // проход 2: записи разбираются на свои места в списке
+    std::vector<size_t> ri(h.entries), ci(h.entries);
+    std::vector<T> vals(h.entries);
+    TThreadPool::instance().parallel_for(chunks, TEXT_CHUNK_MIN, [&](size_t c0, size_t c1) {
+      for (size_t c = c0; c < c1; c++) {
+        const char* pos = bounds[c];
+        const char *line, *eol;
+        for (size_t k = start[c]; next_mtx_line(pos, bounds[c + 1], line, eol); k++) {
+          parse_mtx_entry(line, eol, h, ri[k], ci[k], vals[k], k);
+          if ((h.symmetry == MTX_SKEW) && (ri[k] == ci[k]))
+            throw std::invalid_argument("skew-symmetric matrix has a diagonal entry");
+        }
+      }
+    });
+
+    // повторы складываются, поэтому расстановка - в одном потоке
+    TDynamicMatrix<T> m(h.rows, h.cols, zero_init);
+    T* p = m.data();
+    const size_t ld = m.stride();
+    for (size_t k = 0; k < h.entries; k++) {
+      p[ri[k] * ld + ci[k]] += vals[k];
+      if ((h.symmetry == MTX_SYMMETRIC) && (ri[k] != ci[k]))
+        p[ci[k] * ld + ri[k]] += vals[k];
+      else if (h.symmetry == MTX_SKEW)
+        p[ci[k] * ld + ri[k]] -= vals[k];
+    }
+    return m;
+  }
+
+  template<typename T>
+  TDynamicMatrix<T> parse_mtx_array(const TMtxHeader& h, const char* last)
+  {
+    TDynamicMatrix<T> m(h.rows, h.cols, zero_init);
+    if (h.entries == 0) // кососимметричная матрица 1 x 1
+      return m;
+    // числа - в буфер без ограничения длины вектора (MAX_VECTOR_SIZE):
+    // плотная матрица может быть больше наибольшего вектора
+    const TTextValueChunks t = split_text_values(h.data, last);
+    if (t.start.back() != h.entries)
+      throw std::invalid_argument("the number of entries does not match the header");
+    TArrayBuffer<T> buf(h.entries);
+    const T* vals = buf.get();
+    parse_text_chunks(t, buf.get());
+
+    T* p = m.data();
+    const size_t ld = m.stride();
+    if (h.symmetry == MTX_GENERAL) {
+      // элементы записаны по столбцам: vals - матрица cols x rows
+      transpose_copy(h.cols, h.rows, vals, h.rows, p, ld);
+      return m;
+    }
+    // записан нижний треугольник по столбцам (у skew - без диагонали)
+    size_t k = 0;
+    for (size_t j = 0; j < h.cols; j++)
+      for (size_t i = (h.symmetry == MTX_SKEW ? j + 1 : j); i < h.rows; i++, k++) {
+        p[i * ld + j] = vals[k];
+        if (h.symmetry == MTX_SYMMETRIC)
+          p[j * ld + i] = vals[k];
+        else
+          p[j * ld + i] = -vals[k];
+      }
+    return m;
+  }
+
+  template<typename T>
+  void write_mtx(std::ostream& os, TMtxFormat format, size_t rows, size_t cols, const T* p, size_t ld)
+  {
+    TTextWriter w(os, text_format(' ', TEXT_SHORTEST));
+    w.put(format == MTX_ARRAY ? "%%MatrixMarket matrix array " : "%%MatrixMarket matrix coordinate ");
+    w.put(std::is_integral<T>::value ? "integer general\n" : "real general\n");
+    w.value(rows);
+    w.put(' ');
+    w.value(cols);
+    if (format == MTX_ARRAY) {
+      w.put('\n');
+      for (size_t j = 0; j < cols && w; j++)
+        for (size_t i = 0; i < rows; i++) {
+          w.value(p[i * ld + j]);
+          w.put('\n');
+        }
+    }
+    else {
+      size_t nnz = 0;
+      for (size_t i = 0; i < rows; i++)
+        for (size_t j = 0; j < cols; j++)
+          nnz += p[i * ld + j] != T();
+      w.put(' ');
+      w.value(nnz);
+      w.put('\n');
+      for (size_t i = 0; i < rows && w; i++)
+        for (size_t j = 0; j < cols; j++)
+          if (p[i * ld + j] != T()) {
+            w.value(i + 1);
+            w.put(' ');
+            w.value(j + 1);
+            w.put(' ');
+            w.value(p[i * ld + j]);
+            w.put('\n');
+          }
+    }
+    w.flush();
+    if (!os)
+      throw std::runtime_error("cannot write Matrix Market data");
+  }
+}
+
+// матрица из текста Matrix Market [first, last)
+template<typename T>
+TDynamicMatrix<T> parse_matrix_market(const char* first, const char* last)
+{
+  const tmatrix_detail::TMtxHeader h = tmatrix_detail::parse_mtx_header(first, last);
+  if (h.format == MTX_COORDINATE)
+    return tmatrix_detail::parse_mtx_coordinate<T>(h, last);
+  return tmatrix_detail::parse_mtx_array<T>(h, last);
+}
+
+template<typename T>
+TDynamicMatrix<T> load_matrix_market(const std::string& path)
+{
+  tmatrix_detail::TMappedFile f(path);
+  return parse_matrix_market<T>(f.begin(), f.end());
+}
+
+// чтение из потока до его конца (например, из стандартного ввода)
+template<typename T>
+TDynamicMatrix<T> read_matrix_market(std::istream& is)
+{
+  const std::string text((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  return parse_matrix_market<T>(text.data(), text.data() + text.size());
+}
+
+// запись с кратчайшей точной записью чисел, симметрия - general
+template<typename E>
+void save_matrix_market(std::ostream& os, const TMatExpr<E>& m, TMtxFormat format = MTX_ARRAY)
+{
+  const auto& a = tmatrix_detail::as_matrix(m.self());
+  tmatrix_detail::write_mtx(os, format, a.rows(), a.cols(), a.data(), a.stride());
+}
+
+template<typename E>
+void save_matrix_market(const std::string& path, const TMatExpr<E>& m, TMtxFormat format = MTX_ARRAY)
+{
+  std::ofstream f;
+  tmatrix_detail::open_for_writing(f, path);
+  save_matrix_market(f, m, format);
+}
+#endif
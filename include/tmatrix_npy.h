@@ -0,0 +1,368 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Файлы NumPy: .npy (один массив) и .npz (zip-архив из файлов .npy)
+//
+// .npy: сигнатура "\x93NUMPY", версия, длина заголовка, заголовок -
+// словарь Python вида {'descr': '<f8', 'fortran_order': False,
+// 'shape': (3, 4), }, дополненный пробелами до кратной 64 длины, затем
+// элементы. Одномерный массив - вектор, двумерный - матрица. Типы
+// элементов - как у двоичного формата (tmatrix_binary.h).
+// map_npy_* отображают файл в память и при совпадении порядка байтов и
+// строковом (C) порядке элементов возвращают объект без копирования
+// данных; иначе файл читается обычным образом.
+// .npz читаются и пишутся только без сжатия (np.savez): сжатые архивы
+// np.savez_compressed не поддерживаются. Массив архива с выравниванием
+// данных не хуже alignof(T) тоже отображается без копирования.
+
+#ifndef __TMATRIX_NPY_H__
+#define __TMATRIX_NPY_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tmatrix_binary.h"
+
+namespace tmatrix_detail
+{
+  // сигнатура, версия и длина заголовка (4 байта у версий 2 и 3)
+  const size_t NPY_PREFIX_SIZE = 12;
+
+  // полная длина заголовка .npy по первым NPY_PREFIX_SIZE байтам;
+  // fileSize = 0 - размер файла неизвестен
+  size_t npy_header_length(const unsigned char* prefix, uint64_t fileSize);
+  // разбор заголовка длины len. Данные описываются как в двоичном формате;
+  // при fortranOrder матрица записана по столбцам, и rows x cols -
+  // размеры транспонированной матрицы
+  TBinaryHeader decode_npy_header(const unsigned char* buf, size_t len, uint64_t fileSize, bool& fortranOrder);
+  std::string encode_npy_header(uint8_t type, size_t elemSize, size_t dims, size_t rows, size_t cols);
+
+  // элемент .npz: смещение данных от начала архива и их длина
+  struct TZipEntry
+  {
+    uint64_t offset, size;
+  };
+  // поиск несжатого элемента name.npy в архиве
+  TZipEntry find_npz_entry(const unsigned char* base, size_t length, const std::string& name);
+  uint32_t crc32_update(uint32_t crc, const void* p, size_t n) noexcept;
+
+  template<typename T>
+  void write_npy(std::ostream& os, size_t dims, size_t rows, size_t cols, const T* p, size_t ld)
+  {
+    const std::string header = encode_npy_header(TBinaryTypeOf<T>::value, sizeof(T), dims, rows, cols);
+    os.write(header.data(), std::streamsize(header.size()));
+    write_binary_rows(os, rows, cols, p, ld);
+  }
+
+  inline TBinaryHeader read_npy_header(std::istream& is, bool& fortranOrder)
+  {
+    unsigned char prefix[NPY_PREFIX_SIZE];
+    if (!is.read(reinterpret_cast<char*>(prefix), NPY_PREFIX_SIZE))
+      throw std::runtime_error("unexpected end of .npy data");
+    const size_t len = npy_header_length(prefix, 0);
+    std::vector<unsigned char> buf(len);
+    std::memcpy(buf.data(), prefix, NPY_PREFIX_SIZE);
+    if (!is.read(reinterpret_cast<char*>(buf.data() + NPY_PREFIX_SIZE), std::streamsize(len - NPY_PREFIX_SIZE)))
+      throw std::runtime_error("unexpected end of .npy data");
+    return decode_npy_header(buf.data(), len, 0, fortranOrder);
+  }
+
+  // копия строк данных, лежащих в памяти, в буфер с шагом ld
+  template<typename T>
+  void copy_binary_rows(const TBinaryHeader& h, const char* data, T* p, size_t ld)
+  {
+    for (size_t i = 0; i < h.rows; i++) {
+      std::memcpy(p + i * ld, data + i * h.stride * sizeof(T), h.cols * sizeof(T));
+      if (h.bigEndian != host_big_endian())
+        reverse_bytes(p + i * ld, sizeof(T), h.cols);
+    }
+  }
+
+  // массив .npy, лежащий в памяти начиная с npy (length байтов)
+  struct TNpyArray
+  {
+    TBinaryHeader h;
+    bool fortranOrder;
+    const char* data;
+  };
+
+  inline TNpyArray find_npy_array(const char* npy, uint64_t length)
+  {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(npy);
+    if (length < NPY_PREFIX_SIZE)
+      throw std::invalid_argument("invalid .npy header: file is too short");
+    TNpyArray a;
+    a.h = decode_npy_header(p, npy_header_length(p, length), length, a.fortranOrder);
+    a.data = npy + a.h.offset;
+    return a;
+  }
+
+  template<typename T>
+  TDynamicVector<T> copy_npy_vector(const TNpyArray& a)
+  {
+    check_binary_header<T>(a.h, 1);
+    TDynamicVector<T> v(a.h.rows, uninitialized_init);
+    copy_binary_rows(a.h, a.data, v.data(), 1);
+    return v;
+  }
+
+  template<typename T>
+  TDynamicMatrix<T> copy_npy_matrix(const TNpyArray& a)
+  {
+    check_binary_header<T>(a.h, 2);
+    TDynamicMatrix<T> m(a.h.rows, a.h.cols, uninitialized_init);
+    copy_binary_rows(a.h, a.data, m.data(), m.stride());
+    if (a.fortranOrder)
+      return transpose(m);
+    return m;
+  }
+
+  // данные можно использовать на месте
+  template<typename T>
+  bool npy_in_place(const TNpyArray& a)
+  {
+    return (a.h.bigEndian == host_big_endian()) && !a.fortranOrder
+           && (reinterpret_cast<uintptr_t>(a.data) % alignof(T) == 0);
+  }
+
+  // объект на отображении fm (npy - начало массива в нём, length - его
+  // длина): отображение передаётся объекту или освобождается
+  template<typename T>
+  TDynamicVector<T> map_npy_vector_at(const TFileMapping& fm, const char* npy, uint64_t length)
+  {
+    TNpyArray a;
+    try {
+      a = find_npy_array(npy, length);
+      check_binary_header<T>(a.h, 1);
+      if (!npy_in_place<T>(a)) {
+        TDynamicVector<T> v = copy_npy_vector<T>(a);
+        unmap_file(fm.base, fm.length);
+        return v;
+      }
+    }
+    catch (...) {
+      unmap_file(fm.base, fm.length);
+      throw;
+    }
+    T* p = reinterpret_cast<T*>(const_cast<char*>(a.data));
+    return TDynamicVector<T>(adopt_buffer, p, a.h.rows, [fm](T*) { unmap_file(fm.base, fm.length); });
+  }
+
+  template<typename T>
+  TDynamicMatrix<T> map_npy_matrix_at(const TFileMapping& fm, const char* npy, uint64_t length)
+  {
+    TNpyArray a;
+    try {
+      a = find_npy_array(npy, length);
+      check_binary_header<T>(a.h, 2);
+      if (!npy_in_place<T>(a)) {
+        TDynamicMatrix<T> m = copy_npy_matrix<T>(a);
+        unmap_file(fm.base, fm.length);
+        return m;
+      }
+    }
+    catch (...) {
+      unmap_file(fm.base, fm.length);
+      throw;
+    }
+    T* p = reinterpret_cast<T*>(const_cast<char*>(a.data));
+    return TDynamicMatrix<T>(adopt_buffer, p, a.h.rows, a.h.cols, [fm](T*) { unmap_file(fm.base, fm.length); });
+  }
+
+  inline TZipEntry find_npz_entry(const TMappedFile& f, const std::string& name)
+  {
+    return find_npz_entry(reinterpret_cast<const unsigned char*>(f.begin()), size_t(f.end() - f.begin()), name);
+  }
+}
+
+// запись .npy (поток должен быть открыт в режиме binary)
+template<typename E>
+void save_npy(std::ostream& os, const TVecExpr<E>& v)
+{
+  const auto& a = tmatrix_detail::as_vector(v.self());
+  tmatrix_detail::write_npy(os, 1, a.size(), 1, a.data(), 1);
+}
+
+template<typename E>
+void save_npy(std::ostream& os, const TMatExpr<E>& m)
+{
+  const auto& a = tmatrix_detail::as_matrix(m.self());
+  tmatrix_detail::write_npy(os, 2, a.rows(), a.cols(), a.data(), a.stride());
+}
+
+template<typename E>
+void save_npy(const std::string& path, const TVecExpr<E>& v)
+{
+  std::ofstream f;
+  tmatrix_detail::open_for_writing(f, path);
+  save_npy(f, v);
+}
+
+template<typename E>
+void save_npy(const std::string& path, const TMatExpr<E>& m)
+{
+  std::ofstream f;
+  tmatrix_detail::open_for_writing(f, path);
+  save_npy(f, m);
+}
+
+// чтение .npy с копированием (порядок байтов и элементов исправляется)
+template<typename T>
+TDynamicVector<T> load_npy_vector(std::istream& is)
+{
+  bool fortranOrder;
+  const tmatrix_detail::TBinaryHeader h = tmatrix_detail::read_npy_header(is, fortranOrder);
+  tmatrix_detail::check_binary_header<T>(h, 1);
+  TDynamicVector<T> v(h.rows, uninitialized_init);
+  tmatrix_detail::read_binary_rows(is, h, v.data(), 1);
+  return v;
+}
+
+template<typename T>
+TDynamicMatrix<T> load_npy_matrix(std::istream& is)
+{
+  bool fortranOrder;
+  const tmatrix_detail::TBinaryHeader h = tmatrix_detail::read_npy_header(is, fortranOrder);
+  tmatrix_detail::check_binary_header<T>(h, 2);
+  TDynamicMatrix<T> m(h.rows, h.cols, uninitialized_init);
+  tmatrix_detail::read_binary_rows(is, h, m.data(), m.stride());
+  if (fortranOrder)
+    return transpose(m);
+  return m;
+}
+
+template<typename T>
+TDynamicVector<T> load_npy_vector(const std::string& path)
+{
+  std::ifstream f;
+  tmatrix_detail::open_for_reading(f, path);
+  return load_npy_vector<T>(f);
+}
+
+template<typename T>
+TDynamicMatrix<T> load_npy_matrix(const std::string& path)
+{
+  std::ifstream f;
+  tmatrix_detail::open_for_reading(f, path);
+  return load_npy_matrix<T>(f);
+}
+
+// загрузка .npy без копирования (см. map_binary_*)
+template<typename T>
+TDynamicVector<T> map_npy_vector(const std::string& path)
+{
+  const tmatrix_detail::TFileMapping fm = tmatrix_detail::map_file(path);
+  return tmatrix_detail::map_npy_vector_at<T>(fm, static_cast<const char*>(fm.base), fm.length);
+}
+
+template<typename T>
+TDynamicMatrix<T> map_npy_matrix(const std::string& path)
+{
+  const tmatrix_detail::TFileMapping fm = tmatrix_detail::map_file(path);
+  return tmatrix_detail::map_npy_matrix_at<T>(fm, static_cast<const char*>(fm.base), fm.length);
+}
+
+// массивы архива .npz по имени (без расширения .npy, как в np.load)
+template<typename T>
+TDynamicVector<T> load_npz_vector(const std::string& path, const std::string& name)
+{
+  tmatrix_detail::TMappedFile f(path);
+  const tmatrix_detail::TZipEntry e = tmatrix_detail::find_npz_entry(f, name);
+  return tmatrix_detail::copy_npy_vector<T>(tmatrix_detail::find_npy_array(f.begin() + e.offset, e.size));
+}
+
+template<typename T>
+TDynamicMatrix<T> load_npz_matrix(const std::string& path, const std::string& name)
+{
+  tmatrix_detail::TMappedFile f(path);
+  const tmatrix_detail::TZipEntry e = tmatrix_detail::find_npz_entry(f, name);
+  return tmatrix_detail::copy_npy_matrix<T>(tmatrix_detail::find_npy_array(f.begin() + e.offset, e.size));
+}
+
+template<typename T>
+TDynamicVector<T> map_npz_vector(const std::string& path, const std::string& name)
+{
+  const tmatrix_detail::TFileMapping fm = tmatrix_detail::map_file(path);
+  const char* base = static_cast<const char*>(fm.base);
+  tmatrix_detail::TZipEntry e;
+  try {
+    e = tmatrix_detail::find_npz_entry(reinterpret_cast<const unsigned char*>(base), fm.length, name);
+  }
+  catch (...) {
+    tmatrix_detail::unmap_file(fm.base, fm.length);
+    throw;
+  }
+  return tmatrix_detail::map_npy_vector_at<T>(fm, base + e.offset, e.size);
+}
+
+template<typename T>
+TDynamicMatrix<T> map_npz_matrix(const std::string& path, const std::string& name)
+{
+  const tmatrix_detail::TFileMapping fm = tmatrix_detail::map_file(path);
+  const char* base = static_cast<const char*>(fm.base);
+  tmatrix_detail::TZipEntry e;
+  try {
+    e = tmatrix_detail::find_npz_entry(reinterpret_cast<const unsigned char*>(base), fm.length, name);
+  }
+  catch (...) {
+    tmatrix_detail::unmap_file(fm.base, fm.length);
+    throw;
+  }
+  return tmatrix_detail::map_npy_matrix_at<T>(fm, base + e.offset, e.size);
+}
+
+// Запись архива .npz без сжатия: массивы добавляются по одному,
+// оглавление архива пишется в close() (или в деструкторе)
+class TNpzWriter
+{
+  std::ofstream f;
+  std::string path;
+  std::vector<std::string> names;
+  std::vector<tmatrix_detail::TZipEntry> entries; // смещение локального заголовка и длина
+  std::vector<uint32_t> crcs;
+
+  void begin_entry(const std::string& name, const std::string& header, uint64_t dataSize, uint32_t crc);
+
+  template<typename T>
+  void add_array(const std::string& name, size_t dims, size_t rows, size_t cols, const T* p, size_t ld)
+  {
+    const std::string header = tmatrix_detail::encode_npy_header(tmatrix_detail::TBinaryTypeOf<T>::value,
+                                                                  sizeof(T), dims, rows, cols);
+    uint32_t crc = tmatrix_detail::crc32_update(0, header.data(), header.size());
+    for (size_t i = 0; i < rows; i++)
+      crc = tmatrix_detail::crc32_update(crc, p + i * ld, cols * sizeof(T));
+    begin_entry(name, header, uint64_t(rows) * cols * sizeof(T), crc);
+    tmatrix_detail::write_binary_rows(f, rows, cols, p, ld);
+  }
+public:
+  explicit TNpzWriter(const std::string& path);
+  TNpzWriter(const TNpzWriter&) = delete;
+  TNpzWriter& operator=(const TNpzWriter&) = delete;
+  ~TNpzWriter();
+
+  // name - имя массива для np.load (в архиве - name.npy)
+  template<typename E>
+  void add(const std::string& name, const TVecExpr<E>& v)
+  {
+    const auto& a = tmatrix_detail::as_vector(v.self());
+    add_array(name, 1, a.size(), 1, a.data(), 1);
+  }
+
+  template<typename E>
+  void add(const std::string& name, const TMatExpr<E>& m)
+  {
+    const auto& a = tmatrix_detail::as_matrix(m.self());
+    add_array(name, 2, a.rows(), a.cols(), a.data(), a.stride());
+  }
+
+  void close();
+};
+#endif
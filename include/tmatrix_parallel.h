@@ -0,0 +1,72 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Пул потоков с перехватом задач (work stealing) для матричных операций
+//
+// У каждого рабочего потока своя очередь: владелец берёт задачи с
+// конца, свободные потоки забирают их с начала чужих очередей.
+// Поток, вызвавший parallel_for, тоже выполняет задачи, пока не
+// завершится весь диапазон. Вложенные вызовы из задач выполняются
+// последовательно.
+
+#ifndef __TMATRIX_PARALLEL_H__
+#define __TMATRIX_PARALLEL_H__
+
+#include <cstddef>
+
+class TThreadPool
+{
+public:
+  // общий пул процесса; число потоков по умолчанию - из TMATRIX_THREADS
+  // или по числу ядер
+  static TThreadPool& instance();
+
+  // 0 - по числу ядер; 1 - всё выполняется в вызывающем потоке.
+  // Нельзя вызывать одновременно с parallel_for
+  void set_num_threads(size_t n);
+  size_t num_threads() const noexcept;
+
+  // порог объёма работы (примерное число элементарных операций),
+  // ниже которого parallel_for выполняет диапазон последовательно
+  void set_threshold(size_t work) noexcept;
+  size_t threshold() const noexcept;
+
+  // вызывает f(begin, end) для непересекающихся поддиапазонов [0, n)
+  // и дожидается их завершения; work - число операций на элемент.
+  // Первое исключение из f пробрасывается вызывающему
+  template<typename F>
+  void parallel_for(size_t n, size_t work, const F& f)
+  {
+    if (n < 2 || nThreads < 2 || n * work < minWork || in_task()) {
+      if (n > 0)
+        f(size_t(0), n);
+      return;
+    }
+    run(n, &invoke<F>, &f);
+  }
+
+  TThreadPool(const TThreadPool&) = delete;
+  TThreadPool& operator=(const TThreadPool&) = delete;
+
+private:
+  typedef void (*TRangeFunc)(const void* ctx, size_t begin, size_t end);
+
+  struct TImpl;
+  TImpl* impl;
+  size_t nThreads;
+  size_t minWork;
+
+  TThreadPool();
+  ~TThreadPool();
+
+  template<typename F>
+  static void invoke(const void* ctx, size_t begin, size_t end)
+  {
+    (*static_cast<const F*>(ctx))(begin, end);
+  }
+
+  static bool in_task() noexcept;
+  void run(size_t n, TRangeFunc fn, const void* ctx);
+};
+#endif
@@ -0,0 +1,218 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Разбор больших текстовых файлов с векторами и матрицами
+//
+// Матрица в тексте - по строке текста на строку матрицы, элементы
+// разделяются пробелами, табуляцией, ',' или ';' (подряд идущие
+// разделители считаются одним); пустые строки пропускаются. Вектор -
+// все числа текста подряд. Текст (файл отображается в память целиком)
+// делится на куски по границам строк; куски разбираются параллельно
+// в пуле потоков: первый проход считает строки каждого куска, второй
+// пишет их сразу на место в матрице.
+
+#ifndef __TMATRIX_TEXT_H__
+#define __TMATRIX_TEXT_H__
+
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tmatrix_binary.h"
+#include "tmatrix_charconv.h"
+
+namespace tmatrix_detail
+{
+  // не меньше стольких байтов на кусок текста
+  const size_t TEXT_CHUNK_MIN = size_t(1) << 20;
+
+  // куски [bounds[c], bounds[c + 1]) заканчиваются сразу за символом,
+  // для которого boundary(ch) истинно (или в конце текста)
+  template<typename F>
+  std::vector<const char*> split_text(const char* first, const char* last, const F& boundary)
+  {
+    const size_t size = size_t(last - first);
+    size_t chunks = TThreadPool::instance().num_threads() * 4;
+    if (chunks > size / TEXT_CHUNK_MIN)
+      chunks = size / TEXT_CHUNK_MIN;
+    if (chunks == 0)
+      chunks = 1;
+    std::vector<const char*> bounds(1, first);
+    for (size_t c = 1; c < chunks; c++) {
+      const char* p = first + size / chunks * c;
+      if (p < bounds.back())
+        p = bounds.back();
+      while ((p != last) && !boundary(*p))
+        ++p;
+      if (p != last)
+        ++p;
+      bounds.push_back(p);
+    }
+    bounds.push_back(last);
+    return bounds;
+  }
+
+  // следующая непустая строка текста: [line, eol), pos - за ней
+  inline bool next_text_line(const char*& pos, const char* last, const char*& line, const char*& eol)
+  {
+    while (pos != last) {
+      const char* nl = static_cast<const char*>(std::memchr(pos, '\n', size_t(last - pos)));
+      eol = nl ? nl : last;
+      line = pos;
+      pos = nl ? nl + 1 : last;
+      for (const char* p = line; p != eol; ++p)
+        if (!is_text_space(*p))
+          return true;
+    }
+    return false;
+  }
+
+  // разбор элементов из [first, last) в dst; возвращает их число (не больше max)
+  // либо max + 1, если элементов больше; бросает исключение при ошибке
+  // (row - номер строки матрицы для сообщения, NO_ROW - текст вектора)
+  const size_t NO_ROW = size_t(-1);
+
+  template<typename T>
+  size_t parse_text_values(const char* first, const char* last, T* dst, size_t max, size_t row)
+  {
+    size_t n = 0;
+    const char* p = first;
+    for (;;) {
+      while ((p != last) && is_text_separator(*p))
+        ++p;
+      if (p == last)
+        return n;
+      if (n == max)
+        return max + 1;
+      T val;
+      const char* e = parse_number(p, last, val);
+      if ((e == nullptr) || ((e != last) && !is_text_separator(*e)))
+        throw std::invalid_argument(row == NO_ROW ? std::string("cannot parse a number")
+                                                  : "cannot parse a number in row " + std::to_string(row + 1));
+      dst[n++] = val;
+      p = e;
+    }
+  }
+
+  // число элементов в [first, last) без разбора чисел
+  inline size_t count_text_values(const char* first, const char* last)
+  {
+    size_t n = 0;
+    bool inValue = false;
+    for (const char* p = first; p != last; ++p) {
+      const bool sep = is_text_separator(*p);
+      if (!sep && !inValue)
+        n++;
+      inValue = !sep;
+    }
+    return n;
+  }
+
+  // текст, разбитый на куски по разделителям чисел; start[c] - номер
+  // первого числа куска c, start.back() - число всех чисел
+  struct TTextValueChunks
+  {
+    std::vector<const char*> bounds;
+    std::vector<size_t> start;
+  };
+
+  inline TTextValueChunks split_text_values(const char* first, const char* last)
+  {
+    TTextValueChunks t;
+    t.bounds = split_text(first, last, is_text_separator);
+    const size_t chunks = t.bounds.size() - 1;
+    t.start.assign(chunks + 1, 0);
+    TThreadPool::instance().parallel_for(chunks, TEXT_CHUNK_MIN, [&](size_t c0, size_t c1) {
+      for (size_t c = c0; c < c1; c++)
+        t.start[c + 1] = count_text_values(t.bounds[c], t.bounds[c + 1]);
+    });
+    for (size_t c = 0; c < chunks; c++)
+      t.start[c + 1] += t.start[c];
+    return t;
+  }
+
+  // разбор всех чисел в dst (start.back() элементов), куски - параллельно
+  template<typename T>
+  void parse_text_chunks(const TTextValueChunks& t, T* dst)
+  {
+    TThreadPool::instance().parallel_for(t.bounds.size() - 1, TEXT_CHUNK_MIN, [&](size_t c0, size_t c1) {
+      for (size_t c = c0; c < c1; c++)
+        parse_text_values(t.bounds[c], t.bounds[c + 1], dst + t.start[c], t.start[c + 1] - t.start[c], NO_ROW);
+    });
+  }
+}
+
+// матрица из текста [first, last); число столбцов - по первой строке
+template<typename T>
+TDynamicMatrix<T> parse_text_matrix(const char* first, const char* last)
+{
+  using namespace tmatrix_detail;
+  const std::vector<const char*> bounds = split_text(first, last, [](char c) { return c == '\n'; });
+  const size_t chunks = bounds.size() - 1;
+
+  // проход 1: число непустых строк в каждом куске
+  std::vector<size_t> rowStart(chunks + 1, 0);
+  TThreadPool::instance().parallel_for(chunks, TEXT_CHUNK_MIN, [&](size_t c0, size_t c1) {
+    for (size_t c = c0; c < c1; c++) {
+      const char* pos = bounds[c];
+      const char *line, *eol;
+      size_t rows = 0;
+      while (next_text_line(pos, bounds[c + 1], line, eol))
+        rows++;
+      rowStart[c + 1] = rows;
+    }
+  });
+  for (size_t c = 0; c < chunks; c++)
+    rowStart[c + 1] += rowStart[c];
+
+  const char* pos = first;
+  const char *line, *eol;
+  if (!next_text_line(pos, last, line, eol))
+    throw std::invalid_argument("the text contains no matrix");
+  const size_t cols = count_text_values(line, eol);
+
+  // проход 2: строки разбираются сразу на свои места
+  TDynamicMatrix<T> m(rowStart[chunks], cols);
+  TThreadPool::instance().parallel_for(chunks, TEXT_CHUNK_MIN, [&](size_t c0, size_t c1) {
+    for (size_t c = c0; c < c1; c++) {
+      const char* p = bounds[c];
+      const char *ln, *end;
+      for (size_t i = rowStart[c]; next_text_line(p, bounds[c + 1], ln, end); i++)
+        if (parse_text_values(ln, end, m.data() + i * m.stride(), cols, i) != cols)
+          throw std::invalid_argument("row " + std::to_string(i + 1) + " has a wrong number of elements");
+    }
+  });
+  return m;
+}
+
+// вектор из всех чисел текста [first, last)
+template<typename T>
+TDynamicVector<T> parse_text_vector(const char* first, const char* last)
+{
+  using namespace tmatrix_detail;
+  const TTextValueChunks t = split_text_values(first, last);
+  if (t.start.back() == 0)
+    throw std::invalid_argument("the text contains no vector");
+  TDynamicVector<T> v(t.start.back());
+  parse_text_chunks(t, v.data());
+  return v;
+}
+
+// чтение текстового файла через отображение в память
+template<typename T>
+TDynamicMatrix<T> load_text_matrix(const std::string& path)
+{
+  tmatrix_detail::TMappedFile f(path);
+  return parse_text_matrix<T>(f.begin(), f.end());
+}
+
+template<typename T>
+TDynamicVector<T> load_text_vector(const std::string& path)
+{
+  tmatrix_detail::TMappedFile f(path);
+  return parse_text_vector<T>(f.begin(), f.end());
+}
+#endif
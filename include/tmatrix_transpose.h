@@ -0,0 +1,102 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Блочное транспонирование матриц
+//
+// Матрица обходится блоками TRANSPOSE_BLOCK x TRANSPOSE_BLOCK, исходный
+// блок и блок результата вместе помещаются в L1, поэтому запись по
+// столбцам не вызывает промахов. Внутри блока работают SIMD-ядра 8 x 8
+// (mat_transpose8), края дописываются обычным циклом. Полосы блоков
+// обрабатываются параллельно в пуле потоков.
+
+#ifndef __TMATRIX_TRANSPOSE_H__
+#define __TMATRIX_TRANSPOSE_H__
+
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include "tmatrix_kernels.h"
+#include "tmatrix_parallel.h"
+
+namespace tmatrix_detail
+{
+  // сторона блока: 2 блока по 32 x 32 double - 16 Кбайт
+  const size_t TRANSPOSE_BLOCK = 32;
+
+  // B[n x m] = A[m x n]^T для небольшого блока
+  template<typename T>
+  void transpose_block(size_t m, size_t n, const T* a, size_t lda, T* b, size_t ldb)
+  {
+    size_t i = 0;
+    for (; i + 8 <= m; i += 8) {
+      size_t j = 0;
+      for (; j + 8 <= n; j += 8)
+        mat_transpose8(a + i * lda + j, lda, b + j * ldb + i, ldb);
+      for (; j < n; j++)
+        for (size_t r = 0; r < 8; r++)
+          b[j * ldb + i + r] = a[(i + r) * lda + j];
+    }
+    for (; i < m; i++)
+      for (size_t j = 0; j < n; j++)
+        b[j * ldb + i] = a[i * lda + j];
+  }
+
+  // B[n x m] = A[m x n]^T; каждая задача пула пишет свою полосу строк B
+  template<typename T>
+  void transpose_copy(size_t m, size_t n, const T* a, size_t lda, T* b, size_t ldb)
+  {
+    const size_t BS = TRANSPOSE_BLOCK;
+    TThreadPool::instance().parallel_for((n + BS - 1) / BS, BS * m, [&](size_t b0, size_t b1) {
+      for (size_t jb = b0; jb < b1; jb++) {
+        const size_t j = jb * BS, nc = std::min(BS, n - j);
+        for (size_t i = 0; i < m; i += BS)
+          transpose_block(std::min(BS, m - i), nc, a + i * lda + j, lda, b + j * ldb + i, ldb);
+      }
+    });
+  }
+
+  // A[n x n] = A^T на месте: блоки (I, J) и (J, I) меняются местами
+  // через буфер на стеке, диагональные блоки транспонируются в буфер и
+  // копируются обратно. Пары блоков I <= J делятся между потоками
+  template<typename T>
+  void transpose_square(size_t n, T* a, size_t lda)
+  {
+    const size_t BS = TRANSPOSE_BLOCK;
+    const size_t nb = (n + BS - 1) / BS;
+    TThreadPool::instance().parallel_for(nb * (nb + 1) / 2, BS * BS, [&](size_t p0, size_t p1) {
+      // номер пары -> (I, J) при обходе верхнего треугольника по строкам
+      size_t bi = 0, first = 0;
+      while (p0 - first >= nb - bi) {
+        first += nb - bi;
+        bi++;
+      }
+      size_t bj = bi + (p0 - first);
+      for (size_t p = p0; p < p1; p++) {
+        const size_t i = bi * BS, j = bj * BS;
+        const size_t mi = std::min(BS, n - i), mj = std::min(BS, n - j);
+        T* aij = a + i * lda + j;
+        T* aji = a + j * lda + i;
+        if constexpr (std::is_arithmetic<T>::value) {
+          alignas(64) T buf[TRANSPOSE_BLOCK * TRANSPOSE_BLOCK];
+          transpose_block(mi, mj, aij, lda, buf, BS);
+          if (bi != bj)
+            transpose_block(mj, mi, aji, lda, aij, lda);
+          for (size_t r = 0; r < mj; r++)
+            std::copy(buf + r * BS, buf + r * BS + mi, aji + r * lda);
+        }
+        else {
+          using std::swap;
+          for (size_t r = 0; r < mi; r++)
+            for (size_t c = (bi == bj ? r + 1 : 0); c < mj; c++)
+              swap(aij[r * lda + c], aji[c * lda + r]);
+        }
+        if (++bj == nb)
+          bj = ++bi;
+      }
+    });
+  }
+}
+#endif
@@ -0,0 +1,269 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Верхнетреугольная матрица
+//
+// Хранятся только элементы j >= i: n(n+1)/2 значений построчно в одном
+// буфере, строка i начинается со столбца i. Операции обходят только
+// хранимую половину, нулевая часть не участвует в вычислениях.
+
+#ifndef __TUTMATRIX_H__
+#define __TUTMATRIX_H__
+
+#include <cmath>
+#include <vector>
+
+#include "tmatrix.h"
+
+template<typename T>
+class TUpperTriangularMatrix
+{
+protected:
+  size_t sz;
+  T* pMem;
+
+  // смещение начала строки i в упакованном буфере
+  size_t row_offset(size_t i) const noexcept { return i * sz - i * (i - 1) / 2; }
+  static size_t packed_size(size_t s) noexcept { return s * (s + 1) / 2; }
+
+  // границы кусков строк с равной работой для параллельного обхода:
+  // работа строки i пропорциональна (sz - i)^(d - 1), поэтому на строки
+  // [b, sz) приходится доля ((sz - b) / sz)^d всей работы
+  std::vector<size_t> balanced_rows(double d) const
+  {
+      const size_t parts = std::min(sz, TThreadPool::instance().num_threads() * 4);
+      std::vector<size_t> b(parts + 1);
+      for (size_t p = 0; p <= parts; p++)
+          b[p] = sz - size_t(double(sz) * std::pow(1.0 - double(p) / double(parts), 1.0 / d) + 0.5);
+      return b;
+  }
+public:
+  typedef T value_type;
+
+  TUpperTriangularMatrix(size_t s = 1) : sz(s)
+  {
+    if ((sz <= 0) || (sz > MAX_MATRIX_SIZE))
+        throw out_of_range("matrix size should be greater than zero");
+    pMem = tmatrix_detail::allocate_array<T>(packed_size(sz));
+  }
+  // с нулевыми элементами (см. zero_init в tmatrix_memory.h)
+  TUpperTriangularMatrix(size_t s, TZeroInit tag) : sz(s)
+  {
+    if ((sz <= 0) || (sz > MAX_MATRIX_SIZE))
+        throw out_of_range("matrix size should be greater than zero");
+    tmatrix_detail::TAlignedAllocator<T> a;
+    pMem = tmatrix_detail::allocate_array(a, packed_size(sz), tag);
+  }
+  // верхняя половина квадратной матрицы (элементы ниже диагонали отбрасываются)
+  template<typename A>
+  explicit TUpperTriangularMatrix(const TDynamicMatrix<T, A>& m) : TUpperTriangularMatrix(m.size())
+  {
+      if (m.rows() != m.cols())
+          throw invalid_argument("matrix should be square");
+      for (size_t i = 0; i < sz; i++)
+          copy(m[i].data() + i, m[i].data() + sz, pMem + row_offset(i));
+  }
+  TUpperTriangularMatrix(const TUpperTriangularMatrix& m) : sz(m.sz)
+  {
+      pMem = tmatrix_detail::allocate_array<T>(packed_size(sz));
+      copy(m.pMem, m.pMem + packed_size(sz), pMem);
+  }
+  TUpperTriangularMatrix(TUpperTriangularMatrix&& m) noexcept : sz(0), pMem(nullptr)
+  {
+      swap(*this, m);
+  }
+  ~TUpperTriangularMatrix()
+  {
+      tmatrix_detail::free_array(pMem, packed_size(sz));
+  }
+  TUpperTriangularMatrix& operator=(const TUpperTriangularMatrix& m)
+  {
+      if (this != &m) {
+          if (sz != m.sz) {
+              T* p = tmatrix_detail::allocate_array<T>(packed_size(m.sz));
+              tmatrix_detail::free_array(pMem, packed_size(sz));
+              pMem = p;
+              sz = m.sz;
+          }
+          copy(m.pMem, m.pMem + packed_size(sz), pMem);
+      }
+      return *this;
+  }
+  TUpperTriangularMatrix& operator=(TUpperTriangularMatrix&& m) noexcept
+  {
+      swap(*this, m);
+      return *this;
+  }
+
+  size_t size() const noexcept { return sz; }
+
+  // упакованный буфер из n(n+1)/2 элементов
+  T* data() noexcept { return pMem; }
+  const T* data() const noexcept { return pMem; }
+
+  // хранимая часть строки i: столбцы i..n-1
+  TVectorView<T> row(size_t i)
+  {
+      if (i >= sz)
+          throw out_of_range("index of row is more than a size of matrix");
+      return TVectorView<T>(pMem + row_offset(i), sz - i);
+  }
+  TVectorView<const T> row(size_t i) const
+  {
+      if (i >= sz)
+          throw out_of_range("index of row is more than a size of matrix");
+      return TVectorView<const T>(pMem + row_offset(i), sz - i);
+  }
+
+  // доступ к элементу; изменять можно только элементы j >= i
+  T& operator()(size_t i, size_t j)
+  {
+      if ((i >= sz) || (j >= sz))
+          throw out_of_range("index is more than a size of matrix");
+      if (j < i)
+          throw out_of_range("elements below the diagonal are not stored");
+      return pMem[row_offset(i) + j - i];
+  }
+  T operator()(size_t i, size_t j) const
+  {
+      if ((i >= sz) || (j >= sz))
+          throw out_of_range("index is more than a size of matrix");
+      return (j < i) ? T() : pMem[row_offset(i) + j - i];
+  }
+
+  // полная матрица с нулями ниже диагонали
+  TDynamicMatrix<T> to_dense() const
+  {
+      TDynamicMatrix<T> m(sz);
+      for (size_t i = 0; i < sz; i++) {
+          fill(m[i].data(), m[i].data() + i, T());
+          copy(pMem + row_offset(i), pMem + row_offset(i + 1), m[i].data() + i);
+      }
+      return m;
+  }
+
+  // сравнение
+  bool operator==(const TUpperTriangularMatrix& m) const
+  {
+      return (sz == m.sz) && equal(pMem, pMem + packed_size(sz), m.pMem);
+  }
+  bool operator!=(const TUpperTriangularMatrix& m) const
+  {
+      return !(*this == m);
+  }
+
+  // сумма, разность и умножение на скаляр сохраняют треугольность и
+  // выполняются над упакованными буферами
+  TUpperTriangularMatrix& operator+=(const TUpperTriangularMatrix& m)
+  {
+      if (sz != m.sz)
+          throw invalid_argument("matrix's sizes should be the same");
+      tmatrix_detail::vec_add(pMem, m.pMem, pMem, packed_size(sz));
+      return *this;
+  }
+  TUpperTriangularMatrix& operator-=(const TUpperTriangularMatrix& m)
+  {
+      if (sz != m.sz)
+          throw invalid_argument("matrix's sizes should be the same");
+      tmatrix_detail::vec_sub(pMem, m.pMem, pMem, packed_size(sz));
+      return *this;
+  }
+  TUpperTriangularMatrix& operator*=(const T& val)
+  {
+      tmatrix_detail::vec_scale(pMem, val, pMem, packed_size(sz));
+      return *this;
+  }
+  TUpperTriangularMatrix operator+(const TUpperTriangularMatrix& m) const
+  {
+      if (sz != m.sz)
+          throw invalid_argument("matrix's sizes should be the same");
+      TUpperTriangularMatrix tmp(sz);
+      tmatrix_detail::vec_add(pMem, m.pMem, tmp.pMem, packed_size(sz));
+      return tmp;
+  }
+  TUpperTriangularMatrix operator-(const TUpperTriangularMatrix& m) const
+  {
+      if (sz != m.sz)
+          throw invalid_argument("matrix's sizes should be the same");
+      TUpperTriangularMatrix tmp(sz);
+      tmatrix_detail::vec_sub(pMem, m.pMem, tmp.pMem, packed_size(sz));
+      return tmp;
+  }
+  TUpperTriangularMatrix operator*(const T& val) const
+  {
+      TUpperTriangularMatrix tmp(sz);
+      tmatrix_detail::vec_scale(pMem, val, tmp.pMem, packed_size(sz));
+      return tmp;
+  }
+
+  // матрично-векторное произведение: y[i] = (хранимая строка i, x[i..n-1])
+  template<typename A>
+  TDynamicVector<T> operator*(const TDynamicVector<T, A>& v) const
+  {
+      if (sz != v.size())
+          throw invalid_argument("the length of the vectors must be the same");
+      TDynamicVector<T> res(sz);
+      const std::vector<size_t> rows = balanced_rows(2);
+      const size_t parts = rows.size() - 1;
+      TThreadPool::instance().parallel_for(parts, packed_size(sz) / parts, [&](size_t p0, size_t p1) {
+          for (size_t i = rows[p0]; i < rows[p1]; i++)
+              res.data()[i] = tmatrix_detail::vec_dot(pMem + row_offset(i), v.data() + i, sz - i);
+      });
+      return res;
+  }
+
+  // произведение верхнетреугольных матриц - верхнетреугольная матрица:
+  // строка i результата = сумма по k >= i от A[i][k] * (строка k матрицы B),
+  // обходятся только ненулевые элементы обоих сомножителей
+  TUpperTriangularMatrix operator*(const TUpperTriangularMatrix& m) const
+  {
+      if (sz != m.sz)
+          throw invalid_argument("matrix's sizes should be the same");
+      TUpperTriangularMatrix tmp(sz, zero_init);
+      const std::vector<size_t> rows = balanced_rows(3);
+      const size_t parts = rows.size() - 1;
+      TThreadPool::instance().parallel_for(parts, sz * sz / 6 * sz / parts + 1, [&](size_t p0, size_t p1) {
+          for (size_t i = rows[p0]; i < rows[p1]; i++) {
+              const T* a = pMem + row_offset(i);
+              T* c = tmp.pMem + row_offset(i);
+              for (size_t k = i; k < sz; k++) {
+                  const T aik = a[k - i];
+                  const T* b = m.pMem + m.row_offset(k);
+                  T* ck = c + (k - i);
+                  for (size_t j = 0; j < sz - k; j++)
+                      ck[j] += aik * b[j];
+              }
+          }
+      });
+      return tmp;
+  }
+
+  friend void swap(TUpperTriangularMatrix& lhs, TUpperTriangularMatrix& rhs) noexcept
+  {
+    std::swap(lhs.sz, rhs.sz);
+    std::swap(lhs.pMem, rhs.pMem);
+  }
+
+  // ввод/вывод: вводятся только элементы j >= i построчно,
+  // выводится полная матрица с нулями ниже диагонали
+  friend istream& operator>>(istream& istr, TUpperTriangularMatrix& v)
+  {
+      tmatrix_detail::read_values(istr, v.pMem, packed_size(v.sz));
+      return istr;
+  }
+  friend ostream& operator<<(ostream& ostr, const TUpperTriangularMatrix& v)
+  {
+      tmatrix_detail::TTextWriter w(ostr);
+      for (size_t i = 0; i < v.sz && w; i++) {
+          for (size_t j = 0; j < v.sz; j++) {
+              if (j != 0)
+                  w.put(w.delimiter());
+              w.value(v(i, j));
+          }
+          w.put('\n');
+      }
+      return ostr;
+  }
+};
+#endif
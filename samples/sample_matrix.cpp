@@ -5,12 +5,13 @@
 // Тестирование матриц
 
 #include <iostream>
-#include "tmatrix.h"
+#include <clocale>
+#include "tutmatrix.h"
 //---------------------------------------------------------------------------
 
-void main()
+int main()
 {
-  TDynamicMatrix<int> a(5), b(5), c(5);
+  TUpperTriangularMatrix<int> a(5), b(5), c(5);
   int i, j;
 
   setlocale(LC_ALL, "Russian");
@@ -19,8 +20,8 @@ void main()
   for (i = 0; i < 5; i++)
     for (j = i; j < 5; j++ )
     {
-      a[i][j] =  i * 10 + j;
-      b[i][j] = (i * 10 + j) * 100;
+      a(i, j) =  i * 10 + j;
+      b(i, j) = (i * 10 + j) * 100;
     }
   c = a + b;
   cout << "Matrix a = " << endl << a << endl;
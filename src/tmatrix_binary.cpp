@@ -0,0 +1,203 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Заголовок двоичного формата и отображение файлов в память
+
+#include "tmatrix_binary.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+  const unsigned char MAGIC[8] = { 0x89, 'T', 'M', 'X', '\r', '\n', 0x1a, '\n' };
+  const uint16_t VERSION = 1;
+  const uint32_t DATA_ALIGN = 64;
+
+  void put(unsigned char* p, uint64_t v, size_t bytes)
+  {
+    for (size_t i = 0; i < bytes; i++)
+      p[i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+
+  uint64_t get(const unsigned char* p, size_t bytes)
+  {
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; i++)
+      v |= uint64_t(p[i]) << (8 * i);
+    return v;
+  }
+
+  size_t type_size(uint8_t type)
+  {
+    using namespace tmatrix_detail;
+    switch (type) {
+    case BIN_INT8: case BIN_UINT8: return 1;
+    case BIN_INT16: case BIN_UINT16: return 2;
+    case BIN_INT32: case BIN_UINT32: case BIN_FLOAT32: return 4;
+    case BIN_INT64: case BIN_UINT64: case BIN_FLOAT64: return 8;
+    default: return 0;
+    }
+  }
+
+  void bad_header(const char* what)
+  {
+    throw std::invalid_argument(std::string("invalid binary header: ") + what);
+  }
+}
+
+namespace tmatrix_detail
+{
+  bool host_big_endian() noexcept
+  {
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 0;
+  }
+
+  TBinaryHeader make_binary_header(uint8_t type, size_t elemSize, size_t dims, size_t rows, size_t cols)
+  {
+    TBinaryHeader h;
+    h.version = VERSION;
+    h.type = type;
+    h.bigEndian = host_big_endian();
+    h.dims = uint8_t(dims);
+    h.elemSize = uint32_t(elemSize);
+    h.alignment = DATA_ALIGN;
+    h.rows = rows;
+    h.cols = cols;
+    h.stride = cols;
+    h.offset = BINARY_HEADER_SIZE;
+    return h;
+  }
+
+  void encode_binary_header(const TBinaryHeader& h, unsigned char* buf)
+  {
+    std::memset(buf, 0, BINARY_HEADER_SIZE);
+    std::memcpy(buf, MAGIC, sizeof(MAGIC));
+    put(buf + 8, h.version, 2);
+    buf[10] = h.type;
+    buf[11] = h.bigEndian ? 1 : 0;
+    buf[12] = h.dims;
+    put(buf + 16, h.elemSize, 4);
+    put(buf + 20, h.alignment, 4);
+    put(buf + 24, h.rows, 8);
+    put(buf + 32, h.cols, 8);
+    put(buf + 40, h.stride, 8);
+    put(buf + 48, h.offset, 8);
+  }
+
+  TBinaryHeader decode_binary_header(const unsigned char* buf, uint64_t fileSize)
+  {
+    if ((fileSize != 0) && (fileSize < BINARY_HEADER_SIZE))
+      bad_header("file is too short");
+    if (std::memcmp(buf, MAGIC, sizeof(MAGIC)) != 0)
+      bad_header("wrong signature");
+    TBinaryHeader h;
+    h.version = uint16_t(get(buf + 8, 2));
+    h.type = buf[10];
+    h.bigEndian = (buf[11] & 1) != 0;
+    h.dims = buf[12];
+    h.elemSize = uint32_t(get(buf + 16, 4));
+    h.alignment = uint32_t(get(buf + 20, 4));
+    h.rows = get(buf + 24, 8);
+    h.cols = get(buf + 32, 8);
+    h.stride = get(buf + 40, 8);
+    h.offset = get(buf + 48, 8);
+
+    if (h.version != VERSION)
+      bad_header("unsupported version");
+    if ((type_size(h.type) == 0) || (type_size(h.type) != h.elemSize))
+      bad_header("unknown element type");
+    if ((h.dims != 1) && (h.dims != 2))
+      bad_header("wrong number of dimensions");
+    if ((h.rows == 0) || (h.cols == 0) || (h.stride < h.cols) || ((h.dims == 1) && (h.cols != 1)))
+      bad_header("wrong shape");
+    if ((h.alignment == 0) || ((h.alignment & (h.alignment - 1)) != 0))
+      bad_header("wrong alignment");
+    if ((h.offset < BINARY_HEADER_SIZE) || (h.offset % h.alignment != 0) || (h.offset % h.elemSize != 0))
+      bad_header("wrong data offset");
+    // (rows - 1) * stride + cols элементов без переполнения
+    const uint64_t maxElems = (UINT64_MAX - h.offset) / h.elemSize;
+    if ((h.cols > maxElems) || (h.rows - 1 > (maxElems - h.cols) / h.stride))
+      bad_header("data is too large");
+    const uint64_t end = h.offset + ((h.rows - 1) * h.stride + h.cols) * h.elemSize;
+    if ((fileSize != 0) && (end > fileSize))
+      bad_header("file is shorter than its data");
+    return h;
+  }
+
+  void reverse_bytes(void* p, size_t elemSize, size_t n) noexcept
+  {
+    unsigned char* b = static_cast<unsigned char*>(p);
+    for (size_t i = 0; i < n; i++, b += elemSize)
+      for (size_t l = 0, r = elemSize - 1; l < r; l++, r--) {
+        const unsigned char t = b[l];
+        b[l] = b[r];
+        b[r] = t;
+      }
+  }
+
+#if defined(_WIN32)
+  TFileMapping map_file(const std::string& path)
+  {
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE)
+      throw std::runtime_error("cannot open file " + path);
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || (size.QuadPart == 0) || (uint64_t(size.QuadPart) > SIZE_MAX)) {
+      CloseHandle(f);
+      throw std::runtime_error("cannot map file " + path);
+    }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(f);
+    if (m == nullptr)
+      throw std::runtime_error("cannot map file " + path);
+    void* p = MapViewOfFile(m, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(m);
+    if (p == nullptr)
+      throw std::runtime_error("cannot map file " + path);
+    return TFileMapping{ p, size_t(size.QuadPart) };
+  }
+
+  void unmap_file(void* base, size_t) noexcept
+  {
+    UnmapViewOfFile(base);
+  }
+#else
+  TFileMapping map_file(const std::string& path)
+  {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("cannot open file " + path);
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || (st.st_size <= 0) || (uint64_t(st.st_size) > SIZE_MAX)) {
+      close(fd);
+      throw std::runtime_error("cannot map file " + path);
+    }
+    const size_t length = size_t(st.st_size);
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+      throw std::runtime_error("cannot map file " + path);
+    return TFileMapping{ p, length };
+  }
+
+  void unmap_file(void* base, size_t length) noexcept
+  {
+    munmap(base, length);
+  }
+#endif
+}
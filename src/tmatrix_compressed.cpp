@@ -0,0 +1,286 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Заголовок сжатого формата, перестановка байтов и LZ-кодек блоков
+
+#include "tmatrix_compressed.h"
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+  const unsigned char MAGIC[8] = { 0x89, 'T', 'M', 'Z', '\r', '\n', 0x1a, '\n' };
+  const uint16_t VERSION = 1;
+  const unsigned FLAG_BIG_ENDIAN = 1, FLAG_SHUFFLE = 2;
+
+  // LZ: последовательность - байт-метка (старшие 4 бита - число литералов,
+  // младшие - длина совпадения минус MIN_MATCH; 15 - длина продолжается
+  // байтами до первого, меньшего 255), литералы, смещение совпадения
+  // (2 байта); последняя последовательность - только литералы
+  const size_t MIN_MATCH = 4;
+  const size_t MAX_OFFSET = 65535;
+  const size_t HASH_BITS = 14;
+  const size_t LAST_LITERALS = 5; // совпадение не доходит до конца блока
+  const size_t MATCH_LIMIT = 12;  // и не начинается ближе к концу
+
+  void put(unsigned char* p, uint64_t v, size_t bytes)
+  {
+    for (size_t i = 0; i < bytes; i++)
+      p[i] = static_cast<unsigned char>(v >> (8 * i));
+  }
+
+  uint64_t get(const unsigned char* p, size_t bytes)
+  {
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; i++)
+      v |= uint64_t(p[i]) << (8 * i);
+    return v;
+  }
+
+  uint32_t read32(const unsigned char* p)
+  {
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+  }
+
+  size_t hash32(uint32_t v)
+  {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+  }
+
+  void bad_header(const char* what)
+  {
+    throw std::invalid_argument(std::string("invalid compressed header: ") + what);
+  }
+
+  void corrupted()
+  {
+    throw std::invalid_argument("corrupted compressed block");
+  }
+
+  // длина больше 14 (или 15 для литералов): продолжение байтами по 255
+  unsigned char* put_length(unsigned char* op, size_t len)
+  {
+    for (; len >= 255; len -= 255)
+      *op++ = 255;
+    *op++ = static_cast<unsigned char>(len);
+    return op;
+  }
+
+  // последовательность: литералы [lit, lit + litLen), затем совпадение
+  // (matchLen = 0 - последняя последовательность); nullptr - не хватило места
+  unsigned char* put_sequence(unsigned char* op, unsigned char* oend, const unsigned char* lit, size_t litLen,
+                              size_t offset, size_t matchLen)
+  {
+    if (size_t(oend - op) < 1 + litLen / 255 + 1 + litLen + 2 + matchLen / 255 + 1)
+      return nullptr;
+    unsigned char* token = op++;
+    *token = static_cast<unsigned char>((litLen >= 15 ? 15 : litLen) << 4);
+    if (litLen >= 15)
+      op = put_length(op, litLen - 15);
+    if (litLen != 0)
+      std::memcpy(op, lit, litLen);
+    op += litLen;
+    if (matchLen == 0)
+      return op;
+    put(op, offset, 2);
+    op += 2;
+    const size_t m = matchLen - MIN_MATCH;
+    *token |= static_cast<unsigned char>(m >= 15 ? 15 : m);
+    if (m >= 15)
+      op = put_length(op, m - 15);
+    return op;
+  }
+
+  size_t get_length(const unsigned char*& ip, const unsigned char* iend)
+  {
+    size_t len = 0;
+    unsigned char b;
+    do {
+      if (ip == iend)
+        corrupted();
+      b = *ip++;
+      len += b;
+    } while (b == 255);
+    return len;
+  }
+}
+
+namespace tmatrix_detail
+{
+  void encode_compressed_header(const TCompressedHeader& h, unsigned char* buf)
+  {
+    std::memset(buf, 0, COMPRESSED_HEADER_SIZE);
+    std::memcpy(buf, MAGIC, sizeof(MAGIC));
+    put(buf + 8, VERSION, 2);
+    buf[10] = h.type;
+    buf[11] = static_cast<unsigned char>((h.bigEndian ? FLAG_BIG_ENDIAN : 0) | (h.shuffle ? FLAG_SHUFFLE : 0));
+    put(buf + 12, h.elemSize, 4);
+    put(buf + 16, h.rows, 8);
+    put(buf + 24, h.cols, 8);
+    put(buf + 32, h.blockRows, 8);
+    put(buf + 40, h.blocks, 8);
+  }
+
+  TCompressedHeader decode_compressed_header(const unsigned char* buf, uint64_t fileSize)
+  {
+    if (fileSize < COMPRESSED_HEADER_SIZE)
+      bad_header("file is too short");
+    if (std::memcmp(buf, MAGIC, sizeof(MAGIC)) != 0)
+      bad_header("wrong signature");
+    if (get(buf + 8, 2) != VERSION)
+      bad_header("unsupported version");
+    TCompressedHeader h;
+    h.type = buf[10];
+    h.bigEndian = (buf[11] & FLAG_BIG_ENDIAN) != 0;
+    h.shuffle = (buf[11] & FLAG_SHUFFLE) != 0;
+    h.elemSize = uint32_t(get(buf + 12, 4));
+    h.rows = get(buf + 16, 8);
+    h.cols = get(buf + 24, 8);
+    h.blockRows = get(buf + 32, 8);
+    h.blocks = get(buf + 40, 8);
+
+    if ((h.elemSize == 0) || (h.rows == 0) || (h.cols == 0) || (h.blockRows == 0))
+      bad_header("wrong shape");
+    // блок целиком помещается в памяти
+    if ((h.cols > SIZE_MAX / h.elemSize) || (h.blockRows > SIZE_MAX / (h.cols * h.elemSize)))
+      bad_header("blocks are too large");
+    if (h.blocks != (h.rows - 1) / h.blockRows + 1)
+      bad_header("wrong number of blocks");
+    // индекс блоков - в конце файла
+    if (h.blocks > (fileSize - COMPRESSED_HEADER_SIZE) / COMPRESSED_INDEX_ENTRY)
+      bad_header("file is shorter than its block index");
+    h.indexOffset = fileSize - h.blocks * COMPRESSED_INDEX_ENTRY;
+    return h;
+  }
+
+  void shuffle_bytes(const unsigned char* src, unsigned char* dst, size_t count, size_t elemSize) noexcept
+  {
+    for (size_t e = 0; e < count; e++)
+      for (size_t k = 0; k < elemSize; k++)
+        dst[k * count + e] = src[e * elemSize + k];
+  }
+
+  void unshuffle_bytes(const unsigned char* src, unsigned char* dst, size_t count, size_t elemSize) noexcept
+  {
+    for (size_t k = 0; k < elemSize; k++)
+      for (size_t e = 0; e < count; e++)
+        dst[e * elemSize + k] = src[k * count + e];
+  }
+
+  size_t lz_compress(const unsigned char* src, size_t n, unsigned char* dst, size_t capacity)
+  {
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0); // позиция + 1, 0 - пусто
+    unsigned char* op = dst;
+    unsigned char* const oend = dst + capacity;
+    size_t anchor = 0, i = 0;
+    const size_t limit = n > MATCH_LIMIT ? n - MATCH_LIMIT : 0;
+    while (i < limit) {
+      const uint32_t v = read32(src + i);
+      const size_t h = hash32(v);
+      const size_t cand = table[h];
+      table[h] = uint32_t(i + 1);
+      if ((cand == 0) || (i - (cand - 1) > MAX_OFFSET) || (read32(src + cand - 1) != v)) {
+        i += 1 + ((i - anchor) >> 6); // в несжимаемых данных шаг растёт
+        continue;
+      }
+      const size_t c = cand - 1;
+      size_t len = MIN_MATCH;
+      while ((i + len < n - LAST_LITERALS) && (src[c + len] == src[i + len]))
+        len++;
+      op = put_sequence(op, oend, src + anchor, i - anchor, i - c, len);
+      if (op == nullptr)
+        return 0;
+      i += len;
+      anchor = i;
+    }
+    op = put_sequence(op, oend, src + anchor, n - anchor, 0, 0);
+    return op == nullptr ? 0 : size_t(op - dst);
+  }
+
+  void lz_decompress(const unsigned char* src, size_t n, unsigned char* dst, size_t rawSize)
+  {
+    const unsigned char* ip = src;
+    const unsigned char* const iend = src + n;
+    unsigned char* op = dst;
+    unsigned char* const oend = dst + rawSize;
+    for (;;) {
+      if (ip == iend)
+        corrupted();
+      const unsigned token = *ip++;
+      size_t lit = token >> 4;
+      if (lit == 15)
+        lit += get_length(ip, iend);
+      if ((lit > size_t(iend - ip)) || (lit > size_t(oend - op)))
+        corrupted();
+      if (lit != 0)
+        std::memcpy(op, ip, lit);
+      ip += lit;
+      op += lit;
+      if (ip == iend)
+        break;
+
+      if (iend - ip < 2)
+        corrupted();
+      const size_t offset = size_t(get(ip, 2));
+      ip += 2;
+      size_t len = (token & 15) + MIN_MATCH;
+      if ((token & 15) == 15)
+        len += get_length(ip, iend);
+      if ((offset == 0) || (offset > size_t(op - dst)) || (len > size_t(oend - op)))
+        corrupted();
+      // при перекрытии повторяются последние offset байтов: копируются
+      // куски, кратные offset, каждый вдвое длиннее предыдущего
+      const unsigned char* m = op - offset;
+      for (size_t done = 0; done < len;) {
+        const size_t chunk = std::min(offset + done, len - done);
+        std::memcpy(op + done, m, chunk);
+        done += chunk;
+      }
+      op += len;
+    }
+    if (op != oend)
+      corrupted();
+  }
+
+  size_t compress_block(const unsigned char* raw, size_t n, size_t elemSize, bool shuffle, std::vector<unsigned char>& out)
+  {
+    std::vector<unsigned char> shuffled;
+    if (shuffle) {
+      shuffled.resize(n);
+      shuffle_bytes(raw, shuffled.data(), n / elemSize, elemSize);
+      raw = shuffled.data();
+    }
+    out.resize(n);
+    // позиции в таблице LZ - 32-битные
+    const size_t size = (n > 1) && (n <= UINT32_MAX) ? lz_compress(raw, n, out.data(), n - 1) : 0;
+    if (size != 0) {
+      out.resize(size);
+      return size;
+    }
+    std::memcpy(out.data(), raw, n); // не сжимается - хранится как есть
+    return n;
+  }
+
+  void decompress_block(const unsigned char* src, size_t size, size_t elemSize, bool shuffle,
+                        unsigned char* dst, size_t rawSize, std::vector<unsigned char>& tmp)
+  {
+    unsigned char* out = dst;
+    if (shuffle) {
+      tmp.resize(rawSize);
+      out = tmp.data();
+    }
+    if (size == rawSize)
+      std::memcpy(out, src, rawSize);
+    else if (size < rawSize)
+      lz_decompress(src, size, out, rawSize);
+    else
+      corrupted();
+    if (shuffle)
+      unshuffle_bytes(out, dst, rawSize / elemSize, elemSize);
+  }
+}
@@ -0,0 +1,229 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Выбор SIMD-ядер по CPUID
+
+#include <cstdlib>
+#include <cstring>
+
+#include "tmatrix_kernels_impl.h"
+
+#if defined(TMATRIX_X86_KERNELS)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+  template<typename T>
+  void scalar_add(const T* a, const T* b, T* c, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      c[i] = a[i] + b[i];
+  }
+
+  template<typename T>
+  void scalar_sub(const T* a, const T* b, T* c, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      c[i] = a[i] - b[i];
+  }
+
+  template<typename T>
+  void scalar_scale(const T* a, T s, T* c, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      c[i] = a[i] * s;
+  }
+
+  template<typename T>
+  T scalar_dot(const T* a, const T* b, size_t n)
+  {
+    T sum = T();
+    for (size_t i = 0; i < n; i++)
+      sum += a[i] * b[i];
+    return sum;
+  }
+
+  template<typename T>
+  void scalar_dot4(const T* a, size_t lda, const T* x, size_t n, T* y)
+  {
+    for (size_t r = 0; r < 4; r++)
+      y[r] = scalar_dot(a + r * lda, x, n);
+  }
+
+  template<typename T>
+  void scalar_axpy4(const T* a, size_t lda, const T* x, T* y, size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      y[i] += x[0] * a[i] + x[1] * a[lda + i] + x[2] * a[2 * lda + i] + x[3] * a[3 * lda + i];
+  }
+
+  template<typename T>
+  void scalar_transpose8(const T* a, size_t lda, T* b, size_t ldb)
+  {
+    for (size_t i = 0; i < 8; i++)
+      for (size_t j = 0; j < 8; j++)
+        b[j * ldb + i] = a[i * lda + j];
+  }
+
+  template<typename T>
+  void scalar_gemm_micro(size_t kc, const T* a, const T* b, T* c, size_t ldc, size_t mr, size_t nr)
+  {
+    const size_t MR = tmatrix_detail::TGemmTile<T>::MR;
+    const size_t NR = tmatrix_detail::TGemmTile<T>::NR;
+    T acc[MR][NR] = {};
+    for (size_t p = 0; p < kc; p++) {
+      for (size_t i = 0; i < MR; i++)
+        for (size_t j = 0; j < NR; j++)
+          acc[i][j] += a[i] * b[j];
+      a += MR;
+      b += NR;
+    }
+    for (size_t i = 0; i < mr; i++)
+      for (size_t j = 0; j < nr; j++)
+        c[i * ldc + j] += acc[i][j];
+  }
+
+#define TMATRIX_SCALAR_ROW(T) { &scalar_add<T>, &scalar_sub<T>, &scalar_scale<T>, &scalar_dot<T>, &scalar_dot4<T>, \
+                                &scalar_axpy4<T>, &scalar_transpose8<T>, &scalar_gemm_micro<T> }
+
+  const tmatrix_detail::TKernelSet kernels_scalar = {
+    TMATRIX_SCALAR_ROW(float),
+    TMATRIX_SCALAR_ROW(double),
+    TMATRIX_SCALAR_ROW(int32_t),
+    TMATRIX_SCALAR_ROW(int64_t)
+  };
+
+#if defined(TMATRIX_X86_KERNELS)
+  void cpuid(unsigned leaf, unsigned sub, unsigned r[4])
+  {
+#if defined(_MSC_VER)
+    int t[4];
+    __cpuidex(t, int(leaf), int(sub));
+    for (int i = 0; i < 4; i++)
+      r[i] = unsigned(t[i]);
+#else
+    __cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+  }
+
+  unsigned long long xgetbv0()
+  {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+  }
+
+  tmatrix_detail::TSimdLevel detect_level()
+  {
+    using namespace tmatrix_detail;
+    unsigned r[4];
+    cpuid(0, 0, r);
+    const unsigned maxLeaf = r[0];
+    cpuid(1, 0, r);
+    if (!(r[3] & (1u << 26)))
+      return SIMD_SCALAR;
+    const bool osxsave = (r[2] & (1u << 27)) != 0;
+    const bool avx = (r[2] & (1u << 28)) != 0;
+    const bool fma = (r[2] & (1u << 12)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7)
+      return SIMD_SSE2;
+    // ОС должна сохранять состояние регистров YMM (и ZMM для AVX-512)
+    const unsigned long long xcr0 = xgetbv0();
+    cpuid(7, 0, r);
+    const bool avx2 = (r[1] & (1u << 5)) != 0;
+    const bool avx512 = (r[1] & (1u << 16)) && (r[1] & (1u << 17));
+    if (avx512 && (xcr0 & 0xE6) == 0xE6)
+      return SIMD_AVX512;
+    if (avx2 && fma && (xcr0 & 0x6) == 0x6)
+      return SIMD_AVX2;
+    return SIMD_SSE2;
+  }
+#else
+  tmatrix_detail::TSimdLevel detect_level()
+  {
+    return tmatrix_detail::SIMD_SCALAR;
+  }
+#endif
+
+  // TMATRIX_SIMD позволяет понизить уровень (например, для сравнения в тестах и замерах)
+  tmatrix_detail::TSimdLevel select_level()
+  {
+    using namespace tmatrix_detail;
+    TSimdLevel level = detect_level();
+    if (const char* env = std::getenv("TMATRIX_SIMD")) {
+      for (int l = SIMD_SCALAR; l <= SIMD_AVX512; l++)
+        if (std::strcmp(env, simd_level_name(TSimdLevel(l))) == 0 && l < level)
+          level = TSimdLevel(l);
+    }
+    return level;
+  }
+
+  const tmatrix_detail::TKernelSet& kernel_set()
+  {
+    using namespace tmatrix_detail;
+    static const TKernelSet* const set = [] {
+      switch (simd_level()) {
+#if defined(TMATRIX_X86_KERNELS)
+      case SIMD_AVX512: return &kernels_avx512;
+      case SIMD_AVX2: return &kernels_avx2;
+      case SIMD_SSE2: return &kernels_sse2;
+#endif
+      default: return &kernels_scalar;
+      }
+    }();
+    return *set;
+  }
+}
+
+namespace tmatrix_detail
+{
+  TSimdLevel simd_level()
+  {
+    static const TSimdLevel level = select_level();
+    return level;
+  }
+
+  const char* simd_level_name(TSimdLevel level)
+  {
+    switch (level) {
+    case SIMD_SSE2: return "sse2";
+    case SIMD_AVX2: return "avx2";
+    case SIMD_AVX512: return "avx512";
+    default: return "scalar";
+    }
+  }
+
+  template<> const TVectorKernels<float>* vector_kernels<float>()
+  {
+    static const TVectorKernels<float>* const k = &kernel_set().f32;
+    return k;
+  }
+
+  template<> const TVectorKernels<double>* vector_kernels<double>()
+  {
+    static const TVectorKernels<double>* const k = &kernel_set().f64;
+    return k;
+  }
+
+  template<> const TVectorKernels<int32_t>* vector_kernels<int32_t>()
+  {
+    static const TVectorKernels<int32_t>* const k = &kernel_set().i32;
+    return k;
+  }
+
+  template<> const TVectorKernels<int64_t>* vector_kernels<int64_t>()
+  {
+    static const TVectorKernels<int64_t>* const k = &kernel_set().i64;
+    return k;
+  }
+}
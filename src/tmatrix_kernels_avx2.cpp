@@ -0,0 +1,151 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// SIMD-ядра AVX2 (256 бит, требуется и FMA)
+
+#include <immintrin.h>
+
+#include "tmatrix_kernels_impl.h"
+
+namespace
+{
+  // блок 4 x 4 64-битных элементов
+  void transpose4_64(const double* a, size_t lda, double* b, size_t ldb)
+  {
+    const __m256d r0 = _mm256_loadu_pd(a), r1 = _mm256_loadu_pd(a + lda);
+    const __m256d r2 = _mm256_loadu_pd(a + 2 * lda), r3 = _mm256_loadu_pd(a + 3 * lda);
+    const __m256d t0 = _mm256_unpacklo_pd(r0, r1), t1 = _mm256_unpackhi_pd(r0, r1);
+    const __m256d t2 = _mm256_unpacklo_pd(r2, r3), t3 = _mm256_unpackhi_pd(r2, r3);
+    _mm256_storeu_pd(b, _mm256_permute2f128_pd(t0, t2, 0x20));
+    _mm256_storeu_pd(b + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+    _mm256_storeu_pd(b + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+    _mm256_storeu_pd(b + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+  }
+
+  void transpose8_64(const double* a, size_t lda, double* b, size_t ldb)
+  {
+    transpose4_64(a, lda, b, ldb);
+    transpose4_64(a + 4, lda, b + 4 * ldb, ldb);
+    transpose4_64(a + 4 * lda, lda, b + 4, ldb);
+    transpose4_64(a + 4 * lda + 4, lda, b + 4 * ldb + 4, ldb);
+  }
+  struct F32
+  {
+    typedef float T;
+    typedef __m256 reg;
+    static const size_t W = 8;
+    static reg load(const T* p) { return _mm256_loadu_ps(p); }
+    static void store(T* p, reg r) { _mm256_storeu_ps(p, r); }
+    static reg set1(T s) { return _mm256_set1_ps(s); }
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static T hsum(reg r) { return simd_hsum_generic<F32>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      tmatrix_detail::avx2_transpose8_32(reinterpret_cast<const float*>(a), lda, reinterpret_cast<float*>(b), ldb);
+    }
+  };
+
+  struct F64
+  {
+    typedef double T;
+    typedef __m256d reg;
+    static const size_t W = 4;
+    static reg load(const T* p) { return _mm256_loadu_pd(p); }
+    static void store(T* p, reg r) { _mm256_storeu_pd(p, r); }
+    static reg set1(T s) { return _mm256_set1_pd(s); }
+    static reg zero() { return _mm256_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg madd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static T hsum(reg r) { return simd_hsum_generic<F64>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_64(reinterpret_cast<const double*>(a), lda, reinterpret_cast<double*>(b), ldb);
+    }
+  };
+
+  struct I32
+  {
+    typedef int32_t T;
+    typedef __m256i reg;
+    static const size_t W = 8;
+    static reg load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(T* p, reg r) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+    static reg set1(T s) { return _mm256_set1_epi32(s); }
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return simd_hsum_generic<I32>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      tmatrix_detail::avx2_transpose8_32(reinterpret_cast<const float*>(a), lda, reinterpret_cast<float*>(b), ldb);
+    }
+  };
+
+  struct I64
+  {
+    typedef int64_t T;
+    typedef __m256i reg;
+    static const size_t W = 4;
+    static reg load(const T* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(T* p, reg r) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), r); }
+    static reg set1(T s) { return _mm256_set1_epi64x(s); }
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg add(reg a, reg b) { return _mm256_add_epi64(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_epi64(a, b); }
+    // в AVX2 нет vpmullq: lo*lo + ((hi*lo + lo*hi) << 32)
+    static reg mul(reg a, reg b)
+    {
+      const __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                             _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+      return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+    }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return simd_hsum_generic<I64>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_64(reinterpret_cast<const double*>(a), lda, reinterpret_cast<double*>(b), ldb);
+    }
+  };
+}
+
+namespace tmatrix_detail
+{
+  // распаковка пар строк, перестановка пар внутри 128-битных половин,
+  // затем обмен половинами
+  void avx2_transpose8_32(const float* a, size_t lda, float* b, size_t ldb)
+  {
+    __m256 r[8], t[8];
+    for (size_t i = 0; i < 8; i++)
+      r[i] = _mm256_loadu_ps(a + i * lda);
+    for (size_t i = 0; i < 8; i += 2) {
+      t[i] = _mm256_unpacklo_ps(r[i], r[i + 1]);
+      t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+    }
+    for (size_t i = 0; i < 8; i += 4) {
+      r[i] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+      r[i + 1] = _mm256_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+      r[i + 2] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+      r[i + 3] = _mm256_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+    }
+    for (size_t i = 0; i < 4; i++) {
+      _mm256_storeu_ps(b + i * ldb, _mm256_permute2f128_ps(r[i], r[i + 4], 0x20));
+      _mm256_storeu_ps(b + (i + 4) * ldb, _mm256_permute2f128_ps(r[i], r[i + 4], 0x31));
+    }
+  }
+
+  const TKernelSet kernels_avx2 = {
+    TMATRIX_KERNEL_ROW(F32),
+    TMATRIX_KERNEL_ROW(F64),
+    TMATRIX_KERNEL_ROW(I32),
+    TMATRIX_KERNEL_ROW(I64)
+  };
+}
@@ -0,0 +1,125 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// SIMD-ядра AVX-512 (512 бит, требуются AVX512F и AVX512DQ)
+
+#include <immintrin.h>
+
+#include "tmatrix_kernels_impl.h"
+
+namespace
+{
+  // блок 8 x 8 64-битных элементов: распаковка пар строк, затем две
+  // перестановки 128-битных четвертей
+  void transpose8_64(const double* a, size_t lda, double* b, size_t ldb)
+  {
+    __m512d r[8], t[8];
+    for (size_t i = 0; i < 8; i++)
+      r[i] = _mm512_loadu_pd(a + i * lda);
+    for (size_t i = 0; i < 8; i += 2) {
+      t[i] = _mm512_unpacklo_pd(r[i], r[i + 1]);   // столбцы 0, 2, 4, 6 строк i, i + 1
+      t[i + 1] = _mm512_unpackhi_pd(r[i], r[i + 1]); // столбцы 1, 3, 5, 7
+    }
+    for (size_t c = 0; c < 2; c++) {
+      const __m512d u0 = _mm512_shuffle_f64x2(t[c], t[c + 2], _MM_SHUFFLE(2, 0, 2, 0));
+      const __m512d u1 = _mm512_shuffle_f64x2(t[c + 4], t[c + 6], _MM_SHUFFLE(2, 0, 2, 0));
+      const __m512d u2 = _mm512_shuffle_f64x2(t[c], t[c + 2], _MM_SHUFFLE(3, 1, 3, 1));
+      const __m512d u3 = _mm512_shuffle_f64x2(t[c + 4], t[c + 6], _MM_SHUFFLE(3, 1, 3, 1));
+      _mm512_storeu_pd(b + c * ldb, _mm512_shuffle_f64x2(u0, u1, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm512_storeu_pd(b + (c + 4) * ldb, _mm512_shuffle_f64x2(u0, u1, _MM_SHUFFLE(3, 1, 3, 1)));
+      _mm512_storeu_pd(b + (c + 2) * ldb, _mm512_shuffle_f64x2(u2, u3, _MM_SHUFFLE(2, 0, 2, 0)));
+      _mm512_storeu_pd(b + (c + 6) * ldb, _mm512_shuffle_f64x2(u2, u3, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+  }
+
+  struct F32
+  {
+    typedef float T;
+    typedef __m512 reg;
+    static const size_t W = 16;
+    static reg load(const T* p) { return _mm512_loadu_ps(p); }
+    static void store(T* p, reg r) { _mm512_storeu_ps(p, r); }
+    static reg set1(T s) { return _mm512_set1_ps(s); }
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static T hsum(reg r) { return _mm512_reduce_add_ps(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      tmatrix_detail::avx2_transpose8_32(reinterpret_cast<const float*>(a), lda, reinterpret_cast<float*>(b), ldb);
+    }
+  };
+
+  struct F64
+  {
+    typedef double T;
+    typedef __m512d reg;
+    static const size_t W = 8;
+    static reg load(const T* p) { return _mm512_loadu_pd(p); }
+    static void store(T* p, reg r) { _mm512_storeu_pd(p, r); }
+    static reg set1(T s) { return _mm512_set1_pd(s); }
+    static reg zero() { return _mm512_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg madd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static T hsum(reg r) { return _mm512_reduce_add_pd(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_64(reinterpret_cast<const double*>(a), lda, reinterpret_cast<double*>(b), ldb);
+    }
+  };
+
+  struct I32
+  {
+    typedef int32_t T;
+    typedef __m512i reg;
+    static const size_t W = 16;
+    static reg load(const T* p) { return _mm512_loadu_si512(p); }
+    static void store(T* p, reg r) { _mm512_storeu_si512(p, r); }
+    static reg set1(T s) { return _mm512_set1_epi32(s); }
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return _mm512_reduce_add_epi32(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      tmatrix_detail::avx2_transpose8_32(reinterpret_cast<const float*>(a), lda, reinterpret_cast<float*>(b), ldb);
+    }
+  };
+
+  struct I64
+  {
+    typedef int64_t T;
+    typedef __m512i reg;
+    static const size_t W = 8;
+    static reg load(const T* p) { return _mm512_loadu_si512(p); }
+    static void store(T* p, reg r) { _mm512_storeu_si512(p, r); }
+    static reg set1(T s) { return _mm512_set1_epi64(s); }
+    static reg zero() { return _mm512_setzero_si512(); }
+    static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_epi64(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mullo_epi64(a, b); }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return _mm512_reduce_add_epi64(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_64(reinterpret_cast<const double*>(a), lda, reinterpret_cast<double*>(b), ldb);
+    }
+  };
+}
+
+namespace tmatrix_detail
+{
+  const TKernelSet kernels_avx512 = {
+    TMATRIX_KERNEL_ROW(F32),
+    TMATRIX_KERNEL_ROW(F64),
+    TMATRIX_KERNEL_ROW(I32),
+    TMATRIX_KERNEL_ROW(I64)
+  };
+}
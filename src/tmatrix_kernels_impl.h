@@ -0,0 +1,226 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Общие шаблоны SIMD-ядер. Подключается только из файлов
+// tmatrix_kernels_*.cpp, каждый из которых компилируется со своим набором
+// инструкций и описывает регистры через классы-свойства V:
+//   V::T, V::W (элементов в регистре), V::reg,
+//   load, store, set1, zero, add, sub, mul, madd (a * b + c), hsum, transpose8.
+// Всё определяется в безымянном пространстве имён, чтобы код,
+// собранный под AVX, не подменил при компоновке общие inline-функции.
+
+#ifndef __TMATRIX_KERNELS_IMPL_H__
+#define __TMATRIX_KERNELS_IMPL_H__
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tmatrix_kernels.h"
+
+namespace tmatrix_detail
+{
+  // ядра одного набора инструкций для всех поддерживаемых типов
+  struct TKernelSet
+  {
+    TVectorKernels<float> f32;
+    TVectorKernels<double> f64;
+    TVectorKernels<int32_t> i32;
+    TVectorKernels<int64_t> i64;
+  };
+
+  extern const TKernelSet kernels_sse2;
+  extern const TKernelSet kernels_avx2;
+  extern const TKernelSet kernels_avx512;
+
+  // транспонирование блока 8 x 8 32-битных элементов на 256-битных
+  // регистрах (tmatrix_kernels_avx2.cpp, используется и набором AVX-512)
+  void avx2_transpose8_32(const float* a, size_t lda, float* b, size_t ldb);
+}
+
+namespace
+{
+  template<typename V>
+  void simd_add(const typename V::T* a, const typename V::T* b, typename V::T* c, size_t n)
+  {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W)
+      V::store(c + i, V::add(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++)
+      c[i] = a[i] + b[i];
+  }
+
+  template<typename V>
+  void simd_sub(const typename V::T* a, const typename V::T* b, typename V::T* c, size_t n)
+  {
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W)
+      V::store(c + i, V::sub(V::load(a + i), V::load(b + i)));
+    for (; i < n; i++)
+      c[i] = a[i] - b[i];
+  }
+
+  template<typename V>
+  void simd_scale(const typename V::T* a, typename V::T s, typename V::T* c, size_t n)
+  {
+    const typename V::reg vs = V::set1(s);
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W)
+      V::store(c + i, V::mul(V::load(a + i), vs));
+    for (; i < n; i++)
+      c[i] = a[i] * s;
+  }
+
+  // четыре независимых аккумулятора скрывают задержку сложения
+  template<typename V>
+  typename V::T simd_dot(const typename V::T* a, const typename V::T* b, size_t n)
+  {
+    typename V::reg s0 = V::zero(), s1 = V::zero(), s2 = V::zero(), s3 = V::zero();
+    size_t i = 0;
+    for (; i + 4 * V::W <= n; i += 4 * V::W) {
+      s0 = V::add(s0, V::mul(V::load(a + i), V::load(b + i)));
+      s1 = V::add(s1, V::mul(V::load(a + i + V::W), V::load(b + i + V::W)));
+      s2 = V::add(s2, V::mul(V::load(a + i + 2 * V::W), V::load(b + i + 2 * V::W)));
+      s3 = V::add(s3, V::mul(V::load(a + i + 3 * V::W), V::load(b + i + 3 * V::W)));
+    }
+    for (; i + V::W <= n; i += V::W)
+      s0 = V::add(s0, V::mul(V::load(a + i), V::load(b + i)));
+    typename V::T sum = V::hsum(V::add(V::add(s0, s1), V::add(s2, s3)));
+    for (; i < n; i++)
+      sum += a[i] * b[i];
+    return sum;
+  }
+
+  // четыре строки за проход: каждый загруженный фрагмент x используется
+  // четырежды, аккумуляторы строк независимы
+  template<typename V>
+  void simd_dot4(const typename V::T* a, size_t lda, const typename V::T* x, size_t n, typename V::T* y)
+  {
+    typedef typename V::T T;
+    const T* a0 = a;
+    const T* a1 = a + lda;
+    const T* a2 = a + 2 * lda;
+    const T* a3 = a + 3 * lda;
+    typename V::reg s0 = V::zero(), s1 = V::zero(), s2 = V::zero(), s3 = V::zero();
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) {
+      const typename V::reg xv = V::load(x + i);
+      s0 = V::add(s0, V::mul(V::load(a0 + i), xv));
+      s1 = V::add(s1, V::mul(V::load(a1 + i), xv));
+      s2 = V::add(s2, V::mul(V::load(a2 + i), xv));
+      s3 = V::add(s3, V::mul(V::load(a3 + i), xv));
+    }
+    T r0 = V::hsum(s0), r1 = V::hsum(s1), r2 = V::hsum(s2), r3 = V::hsum(s3);
+    for (; i < n; i++) {
+      r0 += a0[i] * x[i];
+      r1 += a1[i] * x[i];
+      r2 += a2[i] * x[i];
+      r3 += a3[i] * x[i];
+    }
+    y[0] = r0;
+    y[1] = r1;
+    y[2] = r2;
+    y[3] = r3;
+  }
+
+  // y загружается и сохраняется один раз на четыре строки
+  template<typename V>
+  void simd_axpy4(const typename V::T* a, size_t lda, const typename V::T* x, typename V::T* y, size_t n)
+  {
+    typedef typename V::T T;
+    const T* a0 = a;
+    const T* a1 = a + lda;
+    const T* a2 = a + 2 * lda;
+    const T* a3 = a + 3 * lda;
+    const typename V::reg c0 = V::set1(x[0]), c1 = V::set1(x[1]), c2 = V::set1(x[2]), c3 = V::set1(x[3]);
+    size_t i = 0;
+    for (; i + V::W <= n; i += V::W) {
+      typename V::reg acc = V::load(y + i);
+      acc = V::add(acc, V::mul(V::load(a0 + i), c0));
+      acc = V::add(acc, V::mul(V::load(a1 + i), c1));
+      acc = V::add(acc, V::mul(V::load(a2 + i), c2));
+      acc = V::add(acc, V::mul(V::load(a3 + i), c3));
+      V::store(y + i, acc);
+    }
+    for (; i < n; i++)
+      y[i] += x[0] * a0[i] + x[1] * a1[i] + x[2] * a2[i] + x[3] * a3[i];
+  }
+
+  // шаг p микроядра GEMM: строка i блока += a[i] * (NR элементов b)
+  template<typename V, size_t MR, size_t NV>
+  inline void simd_gemm_step(typename V::reg (&acc)[MR][NV], const typename V::T* a, const typename V::T* b)
+  {
+    typename V::reg bv[NV];
+    for (size_t v = 0; v < NV; v++)
+      bv[v] = V::load(b + v * V::W);
+    for (size_t i = 0; i < MR; i++) {
+      const typename V::reg ai = V::set1(a[i]);
+      for (size_t v = 0; v < NV; v++)
+        acc[i][v] = V::madd(ai, bv[v], acc[i][v]);
+    }
+  }
+
+  // блок MR x NR результата - в MR * NR / W регистрах на всей длине kc.
+  // Если строка блока - один регистр (AVX-512), аккумуляторов меньше, чем
+  // нужно для скрытия задержки madd: чётные и нечётные шаги копятся в двух
+  // наборах, которые складываются в конце
+  template<typename V>
+  void simd_gemm_micro(size_t kc, const typename V::T* a, const typename V::T* b, typename V::T* c, size_t ldc,
+                       size_t mr, size_t nr)
+  {
+    typedef typename V::T T;
+    const size_t MR = tmatrix_detail::TGemmTile<T>::MR;
+    const size_t NR = tmatrix_detail::TGemmTile<T>::NR;
+    const size_t NV = NR / V::W;
+    const size_t S = NV == 1 ? 2 : 1;
+    typename V::reg acc[S][MR][NV];
+    for (size_t s = 0; s < S; s++)
+      for (size_t i = 0; i < MR; i++)
+        for (size_t v = 0; v < NV; v++)
+          acc[s][i][v] = V::zero();
+    size_t p = 0;
+    for (; p + S <= kc; p += S)
+      for (size_t s = 0; s < S; s++)
+        simd_gemm_step<V>(acc[s], a + (p + s) * MR, b + (p + s) * NR);
+    for (; p < kc; p++)
+      simd_gemm_step<V>(acc[0], a + p * MR, b + p * NR);
+    for (size_t s = 1; s < S; s++)
+      for (size_t i = 0; i < MR; i++)
+        for (size_t v = 0; v < NV; v++)
+          acc[0][i][v] = V::add(acc[0][i][v], acc[s][i][v]);
+
+    if ((mr == MR) && (nr == NR)) {
+      for (size_t i = 0; i < MR; i++)
+        for (size_t v = 0; v < NV; v++) {
+          T* ci = c + i * ldc + v * V::W;
+          V::store(ci, V::add(V::load(ci), acc[0][i][v]));
+        }
+      return;
+    }
+    // краевой блок: через буфер, в C только mr x nr элементов
+    T buf[MR][NR];
+    for (size_t i = 0; i < MR; i++)
+      for (size_t v = 0; v < NV; v++)
+        V::store(buf[i] + v * V::W, acc[0][i][v]);
+    for (size_t i = 0; i < mr; i++)
+      for (size_t j = 0; j < nr; j++)
+        c[i * ldc + j] += buf[i][j];
+  }
+
+  // сумма элементов регистра через память
+  template<typename V>
+  typename V::T simd_hsum_generic(typename V::reg r)
+  {
+    typename V::T buf[V::W];
+    V::store(buf, r);
+    typename V::T sum = typename V::T();
+    for (size_t i = 0; i < V::W; i++)
+      sum += buf[i];
+    return sum;
+  }
+}
+
+#define TMATRIX_KERNEL_ROW(V) { &simd_add<V>, &simd_sub<V>, &simd_scale<V>, &simd_dot<V>, &simd_dot4<V>, &simd_axpy4<V>, &V::transpose8, \
+                               &simd_gemm_micro<V> }
+
+#endif
@@ -0,0 +1,146 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// SIMD-ядра SSE2 (128 бит)
+
+#include <emmintrin.h>
+#include <xmmintrin.h>
+
+#include "tmatrix_kernels_impl.h"
+
+namespace
+{
+  // блок 8 x 8 32-битных элементов - четыре блока 4 x 4
+  void transpose8_32(const float* a, size_t lda, float* b, size_t ldb)
+  {
+    for (size_t bi = 0; bi < 8; bi += 4)
+      for (size_t bj = 0; bj < 8; bj += 4) {
+        const float* s = a + bi * lda + bj;
+        __m128 r0 = _mm_loadu_ps(s), r1 = _mm_loadu_ps(s + lda);
+        __m128 r2 = _mm_loadu_ps(s + 2 * lda), r3 = _mm_loadu_ps(s + 3 * lda);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        float* d = b + bj * ldb + bi;
+        _mm_storeu_ps(d, r0);
+        _mm_storeu_ps(d + ldb, r1);
+        _mm_storeu_ps(d + 2 * ldb, r2);
+        _mm_storeu_ps(d + 3 * ldb, r3);
+      }
+  }
+
+  // блок 8 x 8 64-битных элементов - шестнадцать блоков 2 x 2
+  void transpose8_64(const double* a, size_t lda, double* b, size_t ldb)
+  {
+    for (size_t bi = 0; bi < 8; bi += 2)
+      for (size_t bj = 0; bj < 8; bj += 2) {
+        const double* s = a + bi * lda + bj;
+        const __m128d r0 = _mm_loadu_pd(s), r1 = _mm_loadu_pd(s + lda);
+        double* d = b + bj * ldb + bi;
+        _mm_storeu_pd(d, _mm_unpacklo_pd(r0, r1));
+        _mm_storeu_pd(d + ldb, _mm_unpackhi_pd(r0, r1));
+      }
+  }
+
+  struct F32
+  {
+    typedef float T;
+    typedef __m128 reg;
+    static const size_t W = 4;
+    static reg load(const T* p) { return _mm_loadu_ps(p); }
+    static void store(T* p, reg r) { _mm_storeu_ps(p, r); }
+    static reg set1(T s) { return _mm_set1_ps(s); }
+    static reg zero() { return _mm_setzero_ps(); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return simd_hsum_generic<F32>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_32(reinterpret_cast<const float*>(a), lda, reinterpret_cast<float*>(b), ldb);
+    }
+  };
+
+  struct F64
+  {
+    typedef double T;
+    typedef __m128d reg;
+    static const size_t W = 2;
+    static reg load(const T* p) { return _mm_loadu_pd(p); }
+    static void store(T* p, reg r) { _mm_storeu_pd(p, r); }
+    static reg set1(T s) { return _mm_set1_pd(s); }
+    static reg zero() { return _mm_setzero_pd(); }
+    static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return simd_hsum_generic<F64>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_64(reinterpret_cast<const double*>(a), lda, reinterpret_cast<double*>(b), ldb);
+    }
+  };
+
+  struct I32
+  {
+    typedef int32_t T;
+    typedef __m128i reg;
+    static const size_t W = 4;
+    static reg load(const T* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(T* p, reg r) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+    static reg set1(T s) { return _mm_set1_epi32(s); }
+    static reg zero() { return _mm_setzero_si128(); }
+    static reg add(reg a, reg b) { return _mm_add_epi32(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_epi32(a, b); }
+    // в SSE2 нет pmulld: перемножаем чётные и нечётные элементы через pmuludq
+    static reg mul(reg a, reg b)
+    {
+      const __m128i even = _mm_mul_epu32(a, b);
+      const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+      return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return simd_hsum_generic<I32>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_32(reinterpret_cast<const float*>(a), lda, reinterpret_cast<float*>(b), ldb);
+    }
+  };
+
+  struct I64
+  {
+    typedef int64_t T;
+    typedef __m128i reg;
+    static const size_t W = 2;
+    static reg load(const T* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    static void store(T* p, reg r) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), r); }
+    static reg set1(T s) { return _mm_set1_epi64x(s); }
+    static reg zero() { return _mm_setzero_si128(); }
+    static reg add(reg a, reg b) { return _mm_add_epi64(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_epi64(a, b); }
+    // младшие 64 бита произведения: lo*lo + ((hi*lo + lo*hi) << 32)
+    static reg mul(reg a, reg b)
+    {
+      const __m128i cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), b),
+                                          _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+      return _mm_add_epi64(_mm_mul_epu32(a, b), _mm_slli_epi64(cross, 32));
+    }
+    static reg madd(reg a, reg b, reg c) { return add(mul(a, b), c); }
+    static T hsum(reg r) { return simd_hsum_generic<I64>(r); }
+    static void transpose8(const T* a, size_t lda, T* b, size_t ldb)
+    {
+      transpose8_64(reinterpret_cast<const double*>(a), lda, reinterpret_cast<double*>(b), ldb);
+    }
+  };
+}
+
+namespace tmatrix_detail
+{
+  const TKernelSet kernels_sse2 = {
+    TMATRIX_KERNEL_ROW(F32),
+    TMATRIX_KERNEL_ROW(F64),
+    TMATRIX_KERNEL_ROW(I32),
+    TMATRIX_KERNEL_ROW(I64)
+  };
+}
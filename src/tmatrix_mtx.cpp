@@ -0,0 +1,126 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Заголовок файлов Matrix Market
+
+#include "tmatrix_mtx.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+  void bad_header(const char* what)
+  {
+    throw std::invalid_argument(std::string("invalid Matrix Market header: ") + what);
+  }
+
+  struct TWord
+  {
+    const char* first;
+    const char* last;
+
+    // сравнение без учёта регистра
+    bool is(const char* word) const
+    {
+      const size_t n = std::strlen(word);
+      if (size_t(last - first) != n)
+        return false;
+      for (size_t i = 0; i < n; i++)
+        if (std::tolower(static_cast<unsigned char>(first[i])) != word[i])
+          return false;
+      return true;
+    }
+  };
+
+  // следующее слово строки; p - за ним
+  bool next_word(const char*& p, const char* eol, TWord& w)
+  {
+    while ((p != eol) && tmatrix_detail::is_text_space(*p))
+      ++p;
+    w.first = p;
+    while ((p != eol) && !tmatrix_detail::is_text_space(*p))
+      ++p;
+    w.last = p;
+    return w.first != w.last;
+  }
+}
+
+namespace tmatrix_detail
+{
+  TMtxHeader parse_mtx_header(const char* first, const char* last)
+  {
+    const char* pos = first;
+    const char *line, *eol;
+    if (!next_text_line(pos, last, line, eol))
+      bad_header("the text is empty");
+
+    // %%MatrixMarket matrix <format> <field> <symmetry>
+    TWord w[5];
+    const char* p = line;
+    for (size_t k = 0; k < 5; k++)
+      if (!next_word(p, eol, w[k]))
+        bad_header("the banner line is incomplete");
+    if (!w[0].is("%%matrixmarket") || !w[1].is("matrix"))
+      bad_header("the file does not contain a Matrix Market matrix");
+
+    TMtxHeader h;
+    if (w[2].is("array"))
+      h.format = MTX_ARRAY;
+    else if (w[2].is("coordinate"))
+      h.format = MTX_COORDINATE;
+    else
+      bad_header("unknown format");
+
+    if (w[3].is("real") || w[3].is("double"))
+      h.field = MTX_REAL;
+    else if (w[3].is("integer"))
+      h.field = MTX_INTEGER;
+    else if (w[3].is("pattern") && (h.format == MTX_COORDINATE))
+      h.field = MTX_PATTERN;
+    else if (w[3].is("complex"))
+      bad_header("complex matrices are not supported");
+    else
+      bad_header("unknown field");
+
+    if (w[4].is("general"))
+      h.symmetry = MTX_GENERAL;
+    else if (w[4].is("symmetric"))
+      h.symmetry = MTX_SYMMETRIC;
+    else if (w[4].is("skew-symmetric"))
+      h.symmetry = MTX_SKEW;
+    else if (w[4].is("hermitian"))
+      bad_header("complex matrices are not supported");
+    else
+      bad_header("unknown symmetry");
+
+    // строки комментариев, затем "rows cols" (array) или "rows cols entries"
+    if (!next_mtx_line(pos, last, line, eol))
+      bad_header("the size line is missing");
+    size_t size[3] = { 0, 0, 0 };
+    const size_t count = h.format == MTX_ARRAY ? 2 : 3;
+    const size_t n = parse_text_values(line, eol, size, count, NO_ROW);
+    if (n != count)
+      bad_header("wrong size line");
+    h.rows = size[0];
+    h.cols = size[1];
+    if ((h.rows == 0) || (h.cols == 0))
+      bad_header("the matrix is empty");
+    if ((h.symmetry != MTX_GENERAL) && (h.rows != h.cols))
+      bad_header("symmetric matrix should be square");
+
+    if (h.rows > SIZE_MAX / h.cols)
+      bad_header("the matrix is too large");
+
+    if (h.format == MTX_COORDINATE)
+      h.entries = size[2];
+    else if (h.symmetry == MTX_GENERAL)
+      h.entries = h.rows * h.cols;
+    else // нижний треугольник (rows * rows не переполняется)
+      h.entries = h.symmetry == MTX_SYMMETRIC ? h.rows * h.rows / 2 + (h.rows + 1) / 2 : h.rows * (h.rows - 1) / 2;
+    h.data = pos;
+    return h;
+  }
+}
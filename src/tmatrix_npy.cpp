@@ -0,0 +1,439 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Заголовки .npy, поиск и запись элементов архивов .npz
+
+#include "tmatrix_npy.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+  const unsigned char NPY_MAGIC[6] = { 0x93, 'N', 'U', 'M', 'P', 'Y' };
+  const size_t NPY_ALIGN = 64;
+  const size_t NPY_MAX_HEADER = 100000; // как max_header_size у np.load
+
+  const uint32_t ZIP_LOCAL = 0x04034b50, ZIP_CENTRAL = 0x02014b50, ZIP_END = 0x06054b50;
+  const uint32_t ZIP64_END = 0x06064b50, ZIP64_LOCATOR = 0x07064b50;
+  const uint32_t ZIP_MAX32 = 0xFFFFFFFF;
+  const uint16_t ZIP_DATE = (1 << 5) | 1; // 01.01.1980
+
+  // тип элементов: код двоичного формата и запись dtype NumPy
+  struct TNpyType
+  {
+    uint8_t type;
+    char kind;
+    size_t size;
+  };
+
+  const TNpyType NPY_TYPES[] = {
+    { tmatrix_detail::BIN_INT8, 'i', 1 }, { tmatrix_detail::BIN_INT16, 'i', 2 },
+    { tmatrix_detail::BIN_INT32, 'i', 4 }, { tmatrix_detail::BIN_INT64, 'i', 8 },
+    { tmatrix_detail::BIN_UINT8, 'u', 1 }, { tmatrix_detail::BIN_UINT16, 'u', 2 },
+    { tmatrix_detail::BIN_UINT32, 'u', 4 }, { tmatrix_detail::BIN_UINT64, 'u', 8 },
+    { tmatrix_detail::BIN_FLOAT32, 'f', 4 }, { tmatrix_detail::BIN_FLOAT64, 'f', 8 }
+  };
+
+  uint64_t get(const unsigned char* p, size_t bytes)
+  {
+    uint64_t v = 0;
+    for (size_t i = 0; i < bytes; i++)
+      v |= uint64_t(p[i]) << (8 * i);
+    return v;
+  }
+
+  void put(std::string& s, uint64_t v, size_t bytes)
+  {
+    for (size_t i = 0; i < bytes; i++)
+      s += static_cast<char>(v >> (8 * i));
+  }
+
+  [[noreturn]] void bad_npy(const std::string& what)
+  {
+    throw std::invalid_argument("invalid .npy header: " + what);
+  }
+
+  [[noreturn]] void bad_npz(const std::string& what)
+  {
+    throw std::invalid_argument("invalid .npz archive: " + what);
+  }
+
+  // разбор словаря заголовка .npy: [p, last)
+  class TNpyDict
+  {
+    const char* first;
+    const char* last;
+
+    void skip_spaces(const char*& p) const
+    {
+      while ((p != last) && std::isspace(static_cast<unsigned char>(*p)))
+        ++p;
+    }
+  public:
+    TNpyDict(const char* f, const char* l) : first(f), last(l) {}
+
+    // значение ключа key: указатель сразу за ':' и пробелами
+    const char* value(const char* key) const
+    {
+      const size_t n = std::strlen(key);
+      for (const char* p = first; p + n + 2 <= last; ++p)
+        if (((*p == '\'') || (*p == '"')) && (p[n + 1] == *p) && (std::memcmp(p + 1, key, n) == 0)) {
+          const char* v = p + n + 2;
+          skip_spaces(v);
+          if ((v == last) || (*v != ':'))
+            bad_npy("wrong dictionary");
+          ++v;
+          skip_spaces(v);
+          return v;
+        }
+      bad_npy(std::string("no key ") + key);
+    }
+
+    // строка в кавычках
+    std::string string(const char* key) const
+    {
+      const char* p = value(key);
+      if ((p == last) || ((*p != '\'') && (*p != '"')))
+        bad_npy("wrong string value");
+      const char* e = p + 1;
+      while ((e != last) && (*e != *p))
+        ++e;
+      if (e == last)
+        bad_npy("wrong string value");
+      return std::string(p + 1, e);
+    }
+
+    bool boolean(const char* key) const
+    {
+      const char* p = value(key);
+      if ((last - p >= 4) && (std::memcmp(p, "True", 4) == 0))
+        return true;
+      if ((last - p >= 5) && (std::memcmp(p, "False", 5) == 0))
+        return false;
+      bad_npy("wrong boolean value");
+    }
+
+    // кортеж целых чисел: (3,) или (3, 4)
+    size_t tuple(const char* key, uint64_t* dims, size_t maxDims) const
+    {
+      const char* p = value(key);
+      if ((p == last) || (*p != '('))
+        bad_npy("wrong shape");
+      ++p;
+      size_t n = 0;
+      for (;;) {
+        skip_spaces(p);
+        if ((p != last) && (*p == ')'))
+          return n;
+        uint64_t d;
+        const char* e = tmatrix_detail::parse_number(p, last, d);
+        if ((e == nullptr) || (n == maxDims))
+          bad_npy("unsupported shape");
+        dims[n++] = d;
+        p = e;
+        skip_spaces(p);
+        if ((p != last) && (*p == ','))
+          ++p;
+        else if ((p == last) || (*p != ')'))
+          bad_npy("wrong shape");
+      }
+    }
+  };
+
+  // таблицы CRC-32 (многочлен 0xEDB88320) для обработки по 8 байтов
+  struct TCrcTable
+  {
+    uint32_t t[8][256];
+
+    TCrcTable()
+    {
+      for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+          c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        t[0][i] = c;
+      }
+      for (size_t k = 1; k < 8; k++)
+        for (size_t i = 0; i < 256; i++)
+          t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+    }
+  };
+
+  const TCrcTable& crc_table()
+  {
+    static const TCrcTable table;
+    return table;
+  }
+}
+
+namespace tmatrix_detail
+{
+  size_t npy_header_length(const unsigned char* prefix, uint64_t fileSize)
+  {
+    if (std::memcmp(prefix, NPY_MAGIC, sizeof(NPY_MAGIC)) != 0)
+      bad_npy("wrong signature");
+    size_t len;
+    if (prefix[6] == 1)
+      len = 10 + size_t(get(prefix + 8, 2));
+    else if ((prefix[6] == 2) || (prefix[6] == 3))
+      len = 12 + size_t(get(prefix + 8, 4));
+    else
+      bad_npy("unsupported version");
+    if ((len < NPY_PREFIX_SIZE) || (len > NPY_MAX_HEADER))
+      bad_npy("wrong header length");
+    if ((fileSize != 0) && (len > fileSize))
+      bad_npy("file is too short");
+    return len;
+  }
+
+  TBinaryHeader decode_npy_header(const unsigned char* buf, size_t len, uint64_t fileSize, bool& fortranOrder)
+  {
+    const size_t start = buf[6] == 1 ? 10 : 12;
+    const TNpyDict dict(reinterpret_cast<const char*>(buf) + start, reinterpret_cast<const char*>(buf) + len);
+
+    TBinaryHeader h;
+    h.version = buf[6];
+    const std::string descr = dict.string("descr");
+    const TNpyType* t = nullptr;
+    if ((descr.size() >= 3) && std::strchr("<>|=", descr[0]))
+      for (const TNpyType& nt : NPY_TYPES)
+        if ((descr[1] == nt.kind) && (descr.substr(2) == std::to_string(nt.size)))
+          t = &nt;
+    if (t == nullptr)
+      bad_npy("unsupported dtype " + descr);
+    h.type = t->type;
+    h.elemSize = uint32_t(t->size);
+    h.bigEndian = descr[0] == '>' || ((descr[0] != '<') && host_big_endian());
+    h.alignment = 1;
+
+    uint64_t shape[2];
+    h.dims = uint8_t(dict.tuple("shape", shape, 2));
+    fortranOrder = dict.boolean("fortran_order") && (h.dims == 2);
+    if (h.dims == 0)
+      bad_npy("unsupported shape");
+    h.rows = shape[fortranOrder ? 1 : 0];
+    h.cols = h.dims == 1 ? 1 : shape[fortranOrder ? 0 : 1];
+    if ((h.rows == 0) || (h.cols == 0))
+      bad_npy("the array is empty");
+    h.stride = h.cols;
+    h.offset = len;
+
+    const uint64_t maxElems = (UINT64_MAX - h.offset) / h.elemSize;
+    if (h.rows > maxElems / h.cols)
+      bad_npy("data is too large");
+    if ((fileSize != 0) && (h.offset + h.rows * h.cols * h.elemSize > fileSize))
+      bad_npy("file is shorter than its data");
+    return h;
+  }
+
+  std::string encode_npy_header(uint8_t type, size_t elemSize, size_t dims, size_t rows, size_t cols)
+  {
+    const TNpyType* t = nullptr;
+    for (const TNpyType& nt : NPY_TYPES)
+      if ((nt.type == type) && (nt.size == elemSize))
+        t = &nt;
+    if (t == nullptr)
+      throw std::invalid_argument("unsupported element type");
+
+    std::string dict = "{'descr': '";
+    dict += elemSize == 1 ? '|' : (host_big_endian() ? '>' : '<');
+    dict += t->kind + std::to_string(elemSize) + "', 'fortran_order': False, 'shape': (" + std::to_string(rows);
+    dict += dims == 1 ? ",), }" : ", " + std::to_string(cols) + "), }";
+
+    // данные с кратного NPY_ALIGN смещения, заголовок оканчивается '\n'
+    const size_t len = (10 + dict.size() + 1 + NPY_ALIGN - 1) / NPY_ALIGN * NPY_ALIGN;
+    std::string header(reinterpret_cast<const char*>(NPY_MAGIC), sizeof(NPY_MAGIC));
+    header += '\x01';
+    header += '\x00';
+    put(header, len - 10, 2);
+    header += dict;
+    header.append(len - header.size() - 1, ' ');
+    header += '\n';
+    return header;
+  }
+
+  TZipEntry find_npz_entry(const unsigned char* base, size_t length, const std::string& name)
+  {
+    // конец центрального каталога - в последних 22 + 65535 байтах
+    if (length < 22)
+      bad_npz("file is too short");
+    size_t end = length - 22;
+    while ((get(base + end, 4) != ZIP_END) && (end > 0) && (length - 22 - end < 65535))
+      end--;
+    if (get(base + end, 4) != ZIP_END)
+      bad_npz("no central directory");
+    uint64_t count = get(base + end + 10, 2);
+    uint64_t dirSize = get(base + end + 12, 4);
+    uint64_t dirOffset = get(base + end + 16, 4);
+    if ((count == 0xFFFF) || (dirSize == ZIP_MAX32) || (dirOffset == ZIP_MAX32)) {
+      // ZIP64: запись-указатель непосредственно перед концом каталога
+      if ((end < 20) || (get(base + end - 20, 4) != ZIP64_LOCATOR))
+        bad_npz("no ZIP64 locator");
+      const uint64_t end64 = get(base + end - 20 + 8, 8);
+      if ((length < 56) || (end64 > length - 56) || (get(base + end64, 4) != ZIP64_END))
+        bad_npz("wrong ZIP64 end record");
+      count = get(base + end64 + 32, 8);
+      dirSize = get(base + end64 + 40, 8);
+      dirOffset = get(base + end64 + 48, 8);
+    }
+    if ((dirOffset > length) || (dirSize > length - dirOffset))
+      bad_npz("wrong central directory");
+
+    const std::string member = name + ".npy";
+    uint64_t pos = dirOffset;
+    const uint64_t dirEnd = dirOffset + dirSize;
+    for (uint64_t k = 0; k < count; k++) {
+      if ((dirEnd - pos < 46) || (get(base + pos, 4) != ZIP_CENTRAL))
+        bad_npz("wrong central directory");
+      const unsigned char* e = base + pos;
+      const size_t nameLen = size_t(get(e + 28, 2)), extraLen = size_t(get(e + 30, 2));
+      const size_t entryLen = 46 + nameLen + extraLen + size_t(get(e + 32, 2));
+      if (dirEnd - pos < entryLen)
+        bad_npz("wrong central directory");
+      pos += entryLen;
+      if ((nameLen != member.size()) || (std::memcmp(e + 46, member.data(), nameLen) != 0))
+        continue;
+
+      if ((get(e + 8, 2) & 1) != 0)
+        bad_npz("encrypted members are not supported");
+      if (get(e + 10, 2) != 0)
+        bad_npz("compressed members are not supported (np.savez_compressed)");
+      uint64_t size = get(e + 20, 4), offset = get(e + 42, 4);
+      const uint64_t uncompressed = get(e + 24, 4);
+      // поля ZIP64 идут в порядке: исходный размер, сжатый размер, смещение
+      const unsigned char* extra = e + 46 + nameLen;
+      for (size_t x = 0; x + 4 <= extraLen; x += 4 + size_t(get(extra + x + 2, 2))) {
+        size_t f = x + 4;
+        const size_t fe = f + size_t(get(extra + x + 2, 2));
+        if ((get(extra + x, 2) != 1) || (fe > extraLen))
+          continue;
+        if ((uncompressed == ZIP_MAX32) && (fe - f >= 8))
+          f += 8;
+        if ((size == ZIP_MAX32) && (fe - f >= 8)) {
+          size = get(extra + f, 8);
+          f += 8;
+        }
+        if ((offset == ZIP_MAX32) && (fe - f >= 8))
+          offset = get(extra + f, 8);
+        break;
+      }
+
+      if ((offset > length - 30) || (get(base + offset, 4) != ZIP_LOCAL))
+        bad_npz("wrong local header of " + member);
+      const uint64_t data = offset + 30 + get(base + offset + 26, 2) + get(base + offset + 28, 2);
+      if ((data > length) || (size > length - data))
+        bad_npz("member " + member + " is out of the archive");
+      return TZipEntry{ data, size };
+    }
+    throw std::invalid_argument("array " + name + " is not found in the archive");
+  }
+
+  uint32_t crc32_update(uint32_t crc, const void* p, size_t n) noexcept
+  {
+    const uint32_t (*t)[256] = crc_table().t;
+    const unsigned char* b = static_cast<const unsigned char*>(p);
+    crc = ~crc;
+    for (; n >= 8; n -= 8, b += 8) {
+      const uint32_t lo = crc ^ uint32_t(get(b, 4));
+      const uint32_t hi = uint32_t(get(b + 4, 4));
+      crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+          ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    }
+    for (; n > 0; n--, b++)
+      crc = t[0][(crc ^ *b) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+  }
+}
+
+TNpzWriter::TNpzWriter(const std::string& p) : path(p)
+{
+  tmatrix_detail::open_for_writing(f, path);
+}
+
+TNpzWriter::~TNpzWriter()
+{
+  try {
+    close();
+  }
+  catch (...) {
+  }
+}
+
+void TNpzWriter::begin_entry(const std::string& name, const std::string& header, uint64_t dataSize, uint32_t crc)
+{
+  if (!f.is_open())
+    throw std::logic_error("the archive is closed");
+  const std::string member = name + ".npy";
+  const uint64_t size = header.size() + dataSize;
+  const std::streamoff offset = f.tellp();
+  if ((offset < 0) || (uint64_t(offset) >= ZIP_MAX32) || (size >= ZIP_MAX32) || (names.size() == 0xFFFF))
+    throw std::runtime_error("cannot write " + path + ": archives over 4 GB are not supported");
+
+  std::string local;
+  put(local, ZIP_LOCAL, 4);
+  put(local, 20, 2); // версия 2.0
+  put(local, 0, 2);  // флаги
+  put(local, 0, 2);  // без сжатия
+  put(local, 0, 2);  // время
+  put(local, ZIP_DATE, 2);
+  put(local, crc, 4);
+  put(local, size, 4);
+  put(local, size, 4);
+  put(local, member.size(), 2);
+  put(local, 0, 2);
+  local += member;
+  local += header;
+  f.write(local.data(), std::streamsize(local.size()));
+  if (!f)
+    throw std::runtime_error("cannot write " + path);
+  names.push_back(member);
+  entries.push_back(tmatrix_detail::TZipEntry{ uint64_t(offset), size });
+  crcs.push_back(crc);
+}
+
+void TNpzWriter::close()
+{
+  if (!f.is_open())
+    return;
+  const std::streamoff dirOffset = f.tellp();
+  std::string dir;
+  for (size_t k = 0; k < names.size(); k++) {
+    put(dir, ZIP_CENTRAL, 4);
+    put(dir, 20, 2); // создано версией 2.0
+    put(dir, 20, 2);
+    put(dir, 0, 2);
+    put(dir, 0, 2);
+    put(dir, 0, 2);
+    put(dir, ZIP_DATE, 2);
+    put(dir, crcs[k], 4);
+    put(dir, entries[k].size, 4);
+    put(dir, entries[k].size, 4);
+    put(dir, names[k].size(), 2);
+    put(dir, 0, 2); // дополнительные поля
+    put(dir, 0, 2); // комментарий
+    put(dir, 0, 2); // номер диска
+    put(dir, 0, 2); // внутренние атрибуты
+    put(dir, 0, 4); // внешние атрибуты
+    put(dir, entries[k].offset, 4);
+    dir += names[k];
+  }
+  const size_t dirSize = dir.size();
+  if ((dirOffset < 0) || (uint64_t(dirOffset) + dirSize >= ZIP_MAX32)) {
+    f.close();
+    throw std::runtime_error("cannot write " + path + ": archives over 4 GB are not supported");
+  }
+  put(dir, ZIP_END, 4);
+  put(dir, 0, 2);
+  put(dir, 0, 2);
+  put(dir, names.size(), 2);
+  put(dir, names.size(), 2);
+  put(dir, dirSize, 4);
+  put(dir, uint64_t(dirOffset), 4);
+  put(dir, 0, 2);
+  f.write(dir.data(), std::streamsize(dir.size()));
+  f.close();
+  if (!f)
+    throw std::runtime_error("cannot write " + path);
+}
@@ -0,0 +1,235 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Пул потоков с перехватом задач
+
+#include "tmatrix_parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  thread_local bool inTask = false;
+
+  // группа задач одного вызова parallel_for
+  struct TBatch
+  {
+    std::mutex m;
+    std::condition_variable done;
+    size_t pending;
+    std::exception_ptr error;
+  };
+
+  struct TTask
+  {
+    void (*fn)(const void*, size_t, size_t);
+    const void* ctx;
+    size_t begin, end;
+    TBatch* batch;
+  };
+
+  struct TQueue
+  {
+    std::mutex m;
+    std::deque<TTask> tasks;
+  };
+
+  size_t default_threads()
+  {
+    if (const char* env = std::getenv("TMATRIX_THREADS")) {
+      const long n = std::atol(env);
+      if (n > 0)
+        return size_t(n);
+    }
+    const unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? hw : 1;
+  }
+}
+
+struct TThreadPool::TImpl
+{
+  std::vector<std::unique_ptr<TQueue>> queues;
+  std::vector<std::thread> workers;
+  std::mutex sleepM;
+  std::condition_variable wake;
+  std::atomic<size_t> queued{0};
+  bool stop = false;
+
+  bool pop_own(size_t id, TTask& t)
+  {
+    TQueue& q = *queues[id];
+    std::lock_guard<std::mutex> lk(q.m);
+    if (q.tasks.empty())
+      return false;
+    t = q.tasks.back();
+    q.tasks.pop_back();
+    queued--;
+    return true;
+  }
+
+  bool steal(size_t from, TTask& t)
+  {
+    for (size_t k = 0; k < queues.size(); k++) {
+      TQueue& q = *queues[(from + k) % queues.size()];
+      std::lock_guard<std::mutex> lk(q.m);
+      if (q.tasks.empty())
+        continue;
+      t = q.tasks.front();
+      q.tasks.pop_front();
+      queued--;
+      return true;
+    }
+    return false;
+  }
+
+  static void execute(const TTask& t)
+  {
+    inTask = true;
+    std::exception_ptr error;
+    try {
+      t.fn(t.ctx, t.begin, t.end);
+    }
+    catch (...) {
+      error = std::current_exception();
+    }
+    inTask = false;
+    // после освобождения мьютекса вызывающий поток может уничтожить batch
+    std::lock_guard<std::mutex> lk(t.batch->m);
+    if (error && !t.batch->error)
+      t.batch->error = error;
+    if (--t.batch->pending == 0)
+      t.batch->done.notify_all();
+  }
+
+  void worker_loop(size_t id)
+  {
+    for (;;) {
+      TTask t;
+      if (pop_own(id, t) || steal(id + 1, t)) {
+        execute(t);
+        continue;
+      }
+      std::unique_lock<std::mutex> lk(sleepM);
+      wake.wait(lk, [this] { return stop || queued > 0; });
+      if (stop && queued == 0)
+        return;
+    }
+  }
+
+  void start(size_t nWorkers)
+  {
+    stop = false;
+    for (size_t i = 0; i < nWorkers; i++)
+      queues.emplace_back(new TQueue);
+    for (size_t i = 0; i < nWorkers; i++)
+      workers.emplace_back(&TImpl::worker_loop, this, i);
+  }
+
+  void shutdown()
+  {
+    {
+      std::lock_guard<std::mutex> lk(sleepM);
+      stop = true;
+    }
+    wake.notify_all();
+    for (std::thread& w : workers)
+      w.join();
+    workers.clear();
+    queues.clear();
+  }
+};
+
+TThreadPool& TThreadPool::instance()
+{
+  static TThreadPool pool;
+  return pool;
+}
+
+TThreadPool::TThreadPool() : impl(new TImpl), nThreads(1), minWork(size_t(1) << 15)
+{
+  set_num_threads(default_threads());
+}
+
+TThreadPool::~TThreadPool()
+{
+  impl->shutdown();
+  delete impl;
+}
+
+void TThreadPool::set_num_threads(size_t n)
+{
+  if (n == 0)
+    n = default_threads();
+  impl->shutdown();
+  nThreads = n;
+  // вызывающий поток работает наравне с остальными
+  impl->start(n - 1);
+}
+
+size_t TThreadPool::num_threads() const noexcept
+{
+  return nThreads;
+}
+
+void TThreadPool::set_threshold(size_t work) noexcept
+{
+  minWork = work;
+}
+
+size_t TThreadPool::threshold() const noexcept
+{
+  return minWork;
+}
+
+bool TThreadPool::in_task() noexcept
+{
+  return inTask;
+}
+
+void TThreadPool::run(size_t n, TRangeFunc fn, const void* ctx)
+{
+  // несколько задач на поток, чтобы свободные потоки могли перехватить хвост
+  const size_t chunks = std::min(n, nThreads * 4);
+  TBatch batch;
+  batch.pending = chunks;
+
+  const size_t nQueues = impl->queues.size();
+  for (size_t c = 0; c < chunks; c++) {
+    TTask t = { fn, ctx, n * c / chunks, n * (c + 1) / chunks, &batch };
+    TQueue& q = *impl->queues[c % nQueues];
+    std::lock_guard<std::mutex> lk(q.m);
+    q.tasks.push_back(t);
+    impl->queued++;
+  }
+  {
+    std::lock_guard<std::mutex> lk(impl->sleepM);
+  }
+  impl->wake.notify_all();
+
+  // помогаем, пока есть задачи, затем ждём чужие
+  TTask t;
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lk(batch.m);
+      if (batch.pending == 0)
+        break;
+    }
+    if (!impl->steal(0, t))
+      break;
+    TImpl::execute(t);
+  }
+  std::unique_lock<std::mutex> lk(batch.m);
+  batch.done.wait(lk, [&batch] { return batch.pending == 0; });
+  if (batch.error)
+    std::rethrow_exception(batch.error);
+}
@@ -0,0 +1,288 @@
+// ННГУ, ИИТММ, Курс "Алгоритмы и структуры данных"
+//
+// Copyright (c) Сысоев А.В.
+//
+// Пул буферов по классам размеров
+//
+// Освобождённый буфер попадает в кэш своего потока; когда кэш класса
+// полон - в общий для процесса стек класса, откуда его может забрать
+// любой поток. Общий стек без блокировок: добавление - CAS вершины,
+// извлечение - обмен вершины на nullptr (забирается весь список, лишние
+// буферы возвращаются обратно цепочкой), поэтому проблемы ABA нет.
+
+#include "tmatrix_memory.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+  using tmatrix_detail::MEM_ALIGN;
+
+  // классы: 64 байта, далее по четыре класса на каждую степень двойки
+  // (шаг 2^(e-2) внутри (2^e, 2^(e+1)]) до 256 Мбайт; буферы крупнее
+  // не кэшируются
+  const unsigned MIN_SHIFT = 6;
+  const unsigned MAX_SHIFT = 28;
+  const size_t MAX_POOLED = size_t(1) << MAX_SHIFT;
+  const size_t CLASS_COUNT = 1 + (MAX_SHIFT - MIN_SHIFT) * 4;
+
+  // сколько буферов одного класса держит кэш потока и общий стек
+  const unsigned LOCAL_LIMIT = 4;
+  const size_t SHARED_LIMIT = 8;
+  // и сколько байтов всех классов вместе: крупные буферы сверх этого
+  // возвращаются системе сразу
+  const size_t LOCAL_BYTES = size_t(64) << 20;
+  const size_t SHARED_BYTES = size_t(256) << 20;
+
+  struct TFreeBlock
+  {
+    TFreeBlock* next;
+  };
+
+  size_t size_class(size_t bytes)
+  {
+    if (bytes <= (size_t(1) << MIN_SHIFT))
+      return 0;
+    unsigned e = MIN_SHIFT;
+    while ((size_t(2) << e) < bytes)
+      e++;
+    const size_t step = size_t(1) << (e - 2);
+    const size_t q = (bytes - (size_t(1) << e) + step - 1) / step; // 1..4
+    return 1 + (e - MIN_SHIFT) * 4 + (q - 1);
+  }
+
+  size_t class_bytes(size_t cls)
+  {
+    if (cls == 0)
+      return size_t(1) << MIN_SHIFT;
+    const unsigned e = MIN_SHIFT + unsigned((cls - 1) / 4);
+    const size_t q = (cls - 1) % 4 + 1;
+    return (size_t(1) << e) + q * (size_t(1) << (e - 2));
+  }
+
+  bool default_enabled()
+  {
+    const char* env = std::getenv("TMATRIX_POOL");
+    return !(env && std::strcmp(env, "0") == 0);
+  }
+
+  std::atomic<bool> enabled(default_enabled());
+  std::atomic<size_t> systemAllocs(0);
+
+  struct TSharedStack
+  {
+    std::atomic<TFreeBlock*> head;
+    std::atomic<size_t> count;
+  };
+  TSharedStack shared[CLASS_COUNT];
+  std::atomic<size_t> sharedBytes(0); // сумма по всем общим стекам
+
+  void* system_allocate(size_t cls, bool zero)
+  {
+    systemAllocs.fetch_add(1, std::memory_order_relaxed);
+    return tmatrix_detail::aligned_block(class_bytes(cls), MEM_ALIGN, zero);
+  }
+
+  // цепочка first..last целиком кладётся в общий стек; байты цепочки
+  // уже учтены в sharedBytes
+  void shared_push(size_t cls, TFreeBlock* first, TFreeBlock* last, size_t n)
+  {
+    TSharedStack& s = shared[cls];
+    s.count.fetch_add(n, std::memory_order_relaxed);
+    TFreeBlock* head = s.head.load(std::memory_order_relaxed);
+    do
+      last->next = head;
+    while (!s.head.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  void shared_release(size_t cls, TFreeBlock* b)
+  {
+    if (shared[cls].count.load(std::memory_order_relaxed) >= SHARED_LIMIT) {
+      tmatrix_detail::free_aligned_block(b);
+      return;
+    }
+    // байты резервируются до добавления, чтобы параллельные освобождения
+    // не превысили SHARED_BYTES
+    const size_t cb = class_bytes(cls);
+    if (sharedBytes.fetch_add(cb, std::memory_order_relaxed) + cb > SHARED_BYTES) {
+      sharedBytes.fetch_sub(cb, std::memory_order_relaxed);
+      tmatrix_detail::free_aligned_block(b);
+      return;
+    }
+    shared_push(cls, b, b, 1);
+  }
+
+  // кэш потока; после его разрушения (завершение потока) буферы идут
+  // прямо в общий стек
+  thread_local int localState = 0; // 0 - не создан, 1 - работает, 2 - разрушен
+
+  struct TLocalCache
+  {
+    TFreeBlock* head[CLASS_COUNT];
+    unsigned count[CLASS_COUNT];
+    size_t bytes; // сумма по всем классам
+
+    TLocalCache() : head(), count(), bytes(0) { localState = 1; }
+    ~TLocalCache()
+    {
+      localState = 2;
+      for (size_t cls = 0; cls < CLASS_COUNT; cls++)
+        release_all(cls, true);
+    }
+
+    void release_all(size_t cls, bool toShared)
+    {
+      while (TFreeBlock* b = head[cls]) {
+        head[cls] = b->next;
+        if (toShared)
+          shared_release(cls, b);
+        else
+          tmatrix_detail::free_aligned_block(b);
+      }
+      bytes -= count[cls] * class_bytes(cls);
+      count[cls] = 0;
+    }
+  };
+
+  TLocalCache* local_cache()
+  {
+    if (localState == 2)
+      return nullptr;
+    thread_local TLocalCache cache;
+    return &cache;
+  }
+
+  TFreeBlock* take(size_t cls)
+  {
+    TLocalCache* local = local_cache();
+    if (local && local->head[cls]) {
+      TFreeBlock* b = local->head[cls];
+      local->head[cls] = b->next;
+      local->count[cls]--;
+      local->bytes -= class_bytes(cls);
+      return b;
+    }
+
+    TSharedStack& s = shared[cls];
+    if (s.head.load(std::memory_order_relaxed) == nullptr)
+      return nullptr;
+    TFreeBlock* list = s.head.exchange(nullptr, std::memory_order_acquire);
+    if (list == nullptr)
+      return nullptr;
+    TFreeBlock* b = list;
+    list = list->next;
+    const size_t cb = class_bytes(cls);
+    size_t taken = 1;
+    // часть остатка - в кэш потока, остальное обратно в общий стек
+    while (list && local && local->count[cls] < LOCAL_LIMIT && local->bytes + cb <= LOCAL_BYTES) {
+      TFreeBlock* next = list->next;
+      list->next = local->head[cls];
+      local->head[cls] = list;
+      local->count[cls]++;
+      local->bytes += cb;
+      list = next;
+      taken++;
+    }
+    s.count.fetch_sub(taken, std::memory_order_relaxed);
+    sharedBytes.fetch_sub(taken * cb, std::memory_order_relaxed);
+    if (list) {
+      TFreeBlock* last = list;
+      size_t n = 1;
+      while (last->next) {
+        last = last->next;
+        n++;
+      }
+      s.count.fetch_sub(n, std::memory_order_relaxed);
+      shared_push(cls, list, last, n);
+    }
+    return b;
+  }
+}
+
+namespace tmatrix_detail
+{
+  // буфер до MAX_POOLED всегда занимает целый класс, даже при выключенном
+  // пуле, - иначе его нельзя было бы вернуть в пул после включения
+  void* pool_allocate(size_t bytes, bool zero)
+  {
+    if (bytes > MAX_POOLED) {
+      systemAllocs.fetch_add(1, std::memory_order_relaxed);
+      return aligned_block(bytes, MEM_ALIGN, zero);
+    }
+    const size_t cls = size_class(bytes);
+    if (!enabled.load(std::memory_order_relaxed))
+      return system_allocate(cls, zero);
+    if (TFreeBlock* b = take(cls)) {
+      if (zero)
+        std::memset(b, 0, bytes);
+      return b;
+    }
+    return system_allocate(cls, zero);
+  }
+
+  void pool_free(void* p, size_t bytes) noexcept
+  {
+    if (p == nullptr)
+      return;
+    if (bytes > MAX_POOLED || !enabled.load(std::memory_order_relaxed)) {
+      free_aligned_block(p);
+      return;
+    }
+    const size_t cls = size_class(bytes);
+    TFreeBlock* b = static_cast<TFreeBlock*>(p);
+    TLocalCache* local = local_cache();
+    const size_t cb = class_bytes(cls);
+    if (local && local->count[cls] < LOCAL_LIMIT && local->bytes + cb <= LOCAL_BYTES) {
+      b->next = local->head[cls];
+      local->head[cls] = b;
+      local->count[cls]++;
+      local->bytes += cb;
+      return;
+    }
+    shared_release(cls, b);
+  }
+}
+
+void TBufferPool::set_enabled(bool on) noexcept
+{
+  if (!on)
+    trim();
+  enabled.store(on, std::memory_order_relaxed);
+}
+
+bool TBufferPool::is_enabled() noexcept
+{
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void TBufferPool::trim() noexcept
+{
+  if (TLocalCache* local = local_cache())
+    for (size_t cls = 0; cls < CLASS_COUNT; cls++)
+      local->release_all(cls, false);
+  for (size_t cls = 0; cls < CLASS_COUNT; cls++) {
+    TFreeBlock* list = shared[cls].head.exchange(nullptr, std::memory_order_acquire);
+    while (list) {
+      TFreeBlock* next = list->next;
+      shared[cls].count.fetch_sub(1, std::memory_order_relaxed);
+      sharedBytes.fetch_sub(class_bytes(cls), std::memory_order_relaxed);
+      tmatrix_detail::free_aligned_block(list);
+      list = next;
+    }
+  }
+}
+
+size_t TBufferPool::system_allocations() noexcept
+{
+  return systemAllocs.load(std::memory_order_relaxed);
+}
+
+size_t TBufferPool::retained_bytes() noexcept
+{
+  size_t bytes = sharedBytes.load(std::memory_order_relaxed);
+  if (localState == 1)
+    bytes += local_cache()->bytes;
+  return bytes;
+}
@@ -0,0 +1,148 @@
+#include "tmatrix_binary.h"
+
+#include <gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// файл удаляется при выходе из теста
+struct TTempFile
+{
+	std::string path;
+	explicit TTempFile(const char* name) : path(name) {}
+	~TTempFile() { std::remove(path.c_str()); }
+};
+
+TDynamicMatrix<double> make_binary_matrix(size_t m, size_t n)
+{
+	TDynamicMatrix<double> a(m, n);
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++)
+			a[i][j] = double(i) + double(j) / 100;
+	return a;
+}
+
+TEST(TBinaryFormat, matrix_survives_stream_round_trip)
+{
+	TDynamicMatrix<double> a = make_binary_matrix(5, 100); // строки с дополнением
+	std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+	save_binary(s, a);
+
+	EXPECT_EQ(64 + 5 * 100 * sizeof(double), s.str().size());
+	EXPECT_EQ(a, load_binary_matrix<double>(s));
+}
+
+TEST(TBinaryFormat, vector_and_expression_can_be_saved)
+{
+	TDynamicVector<int> v(7, fill_init, 3);
+	std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+	save_binary(s, v + v);
+
+	TDynamicVector<int> w = load_binary_vector<int>(s);
+	EXPECT_EQ(v * 2, w);
+}
+
+TEST(TBinaryFormat, mapped_matrix_does_not_copy_and_does_not_change_file)
+{
+	TTempFile f("test_tbinary_map.tmp");
+	TDynamicMatrix<double> a = make_binary_matrix(30, 17);
+	save_binary(f.path, a);
+	{
+		TDynamicMatrix<double> m = map_binary_matrix<double>(f.path);
+		EXPECT_EQ(a, m);
+		EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(m.data()) % 64);
+		m[3][4] = -1;
+		m = m * 2.0;
+		EXPECT_EQ(-2, m[3][4]);
+	}
+	EXPECT_EQ(a, map_binary_matrix<double>(f.path));
+	EXPECT_EQ(a, load_binary_matrix<double>(f.path));
+}
+
+TEST(TBinaryFormat, mapped_vector_can_be_moved_and_assigned)
+{
+	TTempFile f("test_tbinary_vec.tmp");
+	TDynamicVector<float> v(1000);
+	for (size_t i = 0; i < v.size(); i++)
+		v[i] = float(i) / 4;
+	save_binary(f.path, v);
+
+	TDynamicVector<float> w = map_binary_vector<float>(f.path);
+	TDynamicVector<float> u(std::move(w));
+	EXPECT_EQ(v, u);
+	u = v + u;
+	EXPECT_EQ(v * 2.0f, u);
+}
+
+TEST(TBinaryFormat, data_with_other_byte_order_is_converted)
+{
+	TTempFile f("test_tbinary_swap.tmp");
+	TDynamicMatrix<int32_t> a(2, 3);
+	for (size_t i = 0; i < 2; i++)
+		for (size_t j = 0; j < 3; j++)
+			a[i][j] = int32_t(i * 0x01000000 + j * 0x0102);
+	std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+	save_binary(s, a);
+	// тот же файл, записанный машиной с другим порядком байтов
+	std::string bytes = s.str();
+	bytes[11] ^= 1;
+	for (size_t p = 64; p < bytes.size(); p += 4) {
+		std::swap(bytes[p], bytes[p + 3]);
+		std::swap(bytes[p + 1], bytes[p + 2]);
+	}
+	{
+		std::ofstream out(f.path.c_str(), std::ios::binary);
+		out.write(bytes.data(), std::streamsize(bytes.size()));
+	}
+
+	EXPECT_EQ(a, map_binary_matrix<int32_t>(f.path));
+	std::stringstream in(bytes, std::ios::in | std::ios::binary);
+	EXPECT_EQ(a, load_binary_matrix<int32_t>(in));
+}
+
+TEST(TBinaryFormat, mapped_vector_with_padded_elements_is_read)
+{
+	TTempFile f("test_tbinary_strided.tmp");
+	// вектор-столбец из 3 элементов, каждый дополнен до двух
+	tmatrix_detail::TBinaryHeader h = tmatrix_detail::make_binary_header(tmatrix_detail::TBinaryTypeOf<int32_t>::value,
+	                                                                      sizeof(int32_t), 1, 3, 1);
+	h.stride = 2;
+	std::vector<unsigned char> buf(h.offset);
+	tmatrix_detail::encode_binary_header(h, buf.data());
+	const int32_t data[6] = { 7, -1, 8, -1, 9, -1 };
+	{
+		std::ofstream out(f.path.c_str(), std::ios::binary);
+		out.write(reinterpret_cast<const char*>(buf.data()), std::streamsize(buf.size()));
+		out.write(reinterpret_cast<const char*>(data), sizeof(data));
+	}
+
+	TDynamicVector<int32_t> v(3);
+	v[0] = 7;
+	v[1] = 8;
+	v[2] = 9;
+	EXPECT_EQ(v, load_binary_vector<int32_t>(f.path));
+	EXPECT_EQ(v, map_binary_vector<int32_t>(f.path));
+}
+
+TEST(TBinaryFormat, wrong_type_shape_or_header_is_rejected)
+{
+	TTempFile f("test_tbinary_bad.tmp");
+	save_binary(f.path, TDynamicMatrix<float>(3, 4));
+
+	ASSERT_ANY_THROW(map_binary_matrix<double>(f.path));
+	ASSERT_ANY_THROW(map_binary_vector<float>(f.path));
+	ASSERT_NO_THROW(map_binary_matrix<float>(f.path));
+	ASSERT_ANY_THROW(map_binary_matrix<float>("test_tbinary_missing.tmp"));
+
+	std::stringstream s(std::ios::in | std::ios::out | std::ios::binary);
+	save_binary(s, TDynamicMatrix<float>(3, 4));
+	std::string bytes = s.str();
+	std::stringstream truncated(bytes.substr(0, bytes.size() - 1), std::ios::in | std::ios::binary);
+	ASSERT_ANY_THROW(load_binary_matrix<float>(truncated));
+	bytes[1] = 'X';
+	std::stringstream corrupted(bytes, std::ios::in | std::ios::binary);
+	ASSERT_ANY_THROW(load_binary_matrix<float>(corrupted));
+}
\ No newline at end of file
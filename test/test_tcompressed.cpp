@@ -0,0 +1,131 @@
+#include "tmatrix_compressed.h"
+
+#include <gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// разреженная матрица: ненулевой примерно каждый двадцатый элемент
+static TDynamicMatrix<double> make_sparse_matrix(size_t m, size_t n)
+{
+	TDynamicMatrix<double> a(m, n, zero_init);
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = i % 20; j < n; j += 20)
+			a[i][j] = double(i) + double(j) / 4;
+	return a;
+}
+
+static void check_lz_round_trip(const std::vector<unsigned char>& src)
+{
+	std::vector<unsigned char> packed(src.size() + src.size() / 255 + 16), res(src.size());
+	const size_t size = tmatrix_detail::lz_compress(src.data(), src.size(), packed.data(), packed.size());
+	ASSERT_NE(0u, size);
+	tmatrix_detail::lz_decompress(packed.data(), size, res.data(), res.size());
+	EXPECT_EQ(src, res);
+}
+
+TEST(TCompressedFormat, lz_codec_round_trip)
+{
+	std::mt19937 gen(17);
+	for (size_t n : { 0, 1, 5, 12, 13, 100, 70000 }) {
+		std::vector<unsigned char> zeros(n, 0), random(n), pattern(n);
+		for (size_t i = 0; i < n; i++) {
+			random[i] = static_cast<unsigned char>(gen());
+			pattern[i] = static_cast<unsigned char>(i % 7 == 0 ? gen() : i % 3);
+		}
+		check_lz_round_trip(zeros);
+		check_lz_round_trip(random);
+		check_lz_round_trip(pattern);
+	}
+}
+
+TEST(TCompressedFormat, lz_codec_reports_overflow_and_corruption)
+{
+	std::vector<unsigned char> src(1000), packed(1000), res(1000);
+	std::mt19937 gen(3);
+	for (unsigned char& c : src)
+		c = static_cast<unsigned char>(gen());
+	EXPECT_EQ(0u, tmatrix_detail::lz_compress(src.data(), src.size(), packed.data(), src.size() - 1));
+
+	std::vector<unsigned char> zeros(1000, 0);
+	const size_t size = tmatrix_detail::lz_compress(zeros.data(), zeros.size(), packed.data(), packed.size());
+	ASSERT_ANY_THROW(tmatrix_detail::lz_decompress(packed.data(), size - 1, res.data(), res.size()));
+	ASSERT_ANY_THROW(tmatrix_detail::lz_decompress(packed.data(), size, res.data(), res.size() - 1));
+	packed[2] = packed[3] = 0xFF; // смещение за началом данных
+	ASSERT_ANY_THROW(tmatrix_detail::lz_decompress(packed.data(), size, res.data(), res.size()));
+}
+
+TEST(TCompressedFormat, sparse_matrix_is_compressed_and_restored)
+{
+	const char* path = "test_tcompressed.tmz";
+	TDynamicMatrix<double> a = make_sparse_matrix(300, 257);
+	save_compressed(path, a);
+
+	std::ifstream f(path, std::ios::binary | std::ios::ate);
+	EXPECT_LT(size_t(f.tellg()) * 3, a.rows() * a.cols() * sizeof(double));
+	f.close();
+	EXPECT_EQ(a, load_compressed_matrix<double>(path));
+	std::remove(path);
+}
+
+TEST(TCompressedFormat, incompressible_blocks_are_stored)
+{
+	const char* path = "test_tcompressed.tmz";
+	TDynamicMatrix<uint32_t> a(50, 40);
+	std::mt19937 gen(5);
+	for (size_t i = 0; i < 50; i++)
+		for (size_t j = 0; j < 40; j++)
+			a[i][j] = uint32_t(gen());
+	save_compressed(path, a, 8);
+
+	EXPECT_EQ(a, load_compressed_matrix<uint32_t>(path));
+	std::remove(path);
+}
+
+TEST(TCompressedFormat, row_ranges_are_read_from_blocks)
+{
+	const char* path = "test_tcompressed.tmz";
+	TDynamicMatrix<double> a = make_sparse_matrix(100, 30);
+	save_compressed(path, a.submatrix(0, 0, 100, 30), 7);
+	{
+		TCompressedMatrixReader<double> r(path);
+		EXPECT_EQ(100, r.rows());
+		EXPECT_EQ(30, r.cols());
+		EXPECT_EQ(7, r.block_rows());
+
+		TDynamicMatrix<double> part = r.read_rows(13, 30);
+		for (size_t i = 0; i < 30; i++)
+			ASSERT_EQ(a[13 + i][5], part[i][5]);
+		// в часть уже выделенной матрицы с другим шагом строк
+		TDynamicMatrix<double> wide(20, 40, zero_init);
+		r.read_rows(90, wide.submatrix(5, 10, 10, 30));
+		EXPECT_EQ(a[99][29], wide[14][39]);
+		EXPECT_EQ(a[90][0], wide[5][10]);
+		EXPECT_EQ(0, wide[4][10]);
+
+		ASSERT_ANY_THROW(r.read_rows(95, 10));
+		ASSERT_ANY_THROW(r.read_rows(0, wide.submatrix(0, 0, 5, 29)));
+	}
+	ASSERT_ANY_THROW(TCompressedMatrixReader<float> wrong(path));
+	std::remove(path);
+}
+
+TEST(TCompressedFormat, empty_row_range_is_read_without_blocks)
+{
+	const char* path = "test_tcompressed.tmz";
+	save_compressed(path, make_sparse_matrix(20, 4), 7);
+	{
+		TCompressedMatrixReader<double> r(path);
+		double buf[4] = { 1, 2, 3, 4 };
+		ASSERT_NO_THROW(r.read_rows(0, TMatrixView<double>(buf, 0, 4)));
+		ASSERT_NO_THROW(r.read_rows(13, TMatrixView<double>(buf, 0, 4)));
+		ASSERT_NO_THROW(r.read_rows(20, TMatrixView<double>(buf, 0, 4)));
+		EXPECT_EQ(1, buf[0]);
+		ASSERT_ANY_THROW(r.read_rows(21, TMatrixView<double>(buf, 0, 4)));
+	}
+	std::remove(path);
+}
\ No newline at end of file
@@ -2,6 +2,9 @@
 
 #include <gtest.h>
 
+#include <cstdint>
+#include <string>
+
 TEST(TDynamicMatrix, can_create_matrix_with_positive_length)
 {
 	ASSERT_NO_THROW(TDynamicMatrix<int> m(5));
@@ -61,13 +64,13 @@ TEST(TDynamicMatrix, can_set_and_get_element)
 TEST(TDynamicMatrix, throws_when_set_element_with_negative_index)
 {
 	TDynamicMatrix<int> m(2);
-	ASSERT_ANY_THROW(m[-1][1] = 2);
+	ASSERT_ANY_THROW(m.at(-1).at(1) = 2);
 }
 
 TEST(TDynamicMatrix, throws_when_set_element_with_too_large_index)
 {
 	TDynamicMatrix<int> m(2);
-	ASSERT_ANY_THROW(m[0][2] = 2);
+	ASSERT_ANY_THROW(m.at(0).at(2) = 2);
 }
 
 TEST(TDynamicMatrix, can_assign_matrix_to_itself)
@@ -186,4 +189,643 @@ TEST(TDynamicMatrix, cant_subtract_matrixes_with_not_equal_size)
 	TDynamicMatrix<int> m2(4);
 
 	ASSERT_ANY_THROW(m1 - m2);
+}
+
+TEST(TDynamicMatrix, rows_are_stored_in_one_contiguous_buffer)
+{
+	TDynamicMatrix<int> m(3);
+	for (int i = 0; i < size(m); i++)
+		EXPECT_EQ(m.data() + i * m.stride(), m[i].data());
+}
+
+TEST(TDynamicMatrix, row_view_writes_through_to_matrix)
+{
+	TDynamicMatrix<int> m(2);
+	TDynamicVector<int> v(2);
+	v[0] = 7;
+	v[1] = 8;
+	m[1] = v;
+	EXPECT_EQ(7, m[1][0]);
+	EXPECT_EQ(8, m.data()[3]);
+}
+
+TEST(TDynamicMatrix, can_multiply_matrix_by_vector)
+{
+	TDynamicMatrix<int> m(2);
+	m[0][0] = 1; m[0][1] = 2;
+	m[1][0] = 3; m[1][1] = 4;
+	TDynamicVector<int> v(2);
+	v[0] = 1;
+	v[1] = 1;
+
+	TDynamicVector<int> res(2);
+	res[0] = 3;
+	res[1] = 7;
+	EXPECT_EQ(res, m * v);
+}
+
+TEST(TDynamicMatrix, can_multiply_matrices_with_equal_size)
+{
+	TDynamicMatrix<int> m1(2);
+	m1[0][0] = 1; m1[0][1] = 2;
+	m1[1][0] = 3; m1[1][1] = 4;
+	TDynamicMatrix<int> m2(2);
+	m2[0][0] = 5; m2[0][1] = 6;
+	m2[1][0] = 7; m2[1][1] = 8;
+
+	TDynamicMatrix<int> m(2);
+	m[0][0] = 19; m[0][1] = 22;
+	m[1][0] = 43; m[1][1] = 50;
+	EXPECT_EQ(m, m1 * m2);
+}
+
+TEST(TDynamicMatrix, cant_multiply_matrices_with_not_equal_size)
+{
+	TDynamicMatrix<int> m1(2);
+	TDynamicMatrix<int> m2(3);
+
+	ASSERT_ANY_THROW(m1 * m2);
+}
+
+TEST(TDynamicMatrix, blocked_product_matches_naive_product)
+{
+	const int n = 150;
+	TDynamicMatrix<int> m1(n), m2(n), m(n);
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			m1[i][j] = (i * 7 + j) % 11 - 5;
+			m2[i][j] = (i + j * 3) % 13 - 6;
+		}
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			int sum = 0;
+			for (int k = 0; k < n; k++)
+				sum += m1[i][k] * m2[k][j];
+			m[i][j] = sum;
+		}
+	EXPECT_EQ(m, m1 * m2);
+}
+
+TEST(TDynamicMatrix, blocked_product_handles_edge_tiles_for_floating_types)
+{
+	// неполные блоки микроядра по строкам и столбцам, несколько панелей по k
+	const size_t m = 37, k = 300, n = 53;
+	TDynamicMatrix<double> a(m, k), b(k, n), c(m, n);
+	TDynamicMatrix<float> af(m, k), bf(k, n);
+	for (size_t i = 0; i < m; i++)
+		for (size_t p = 0; p < k; p++)
+			af[i][p] = float(a[i][p] = double((i * 7 + p) % 11) - 5);
+	for (size_t p = 0; p < k; p++)
+		for (size_t j = 0; j < n; j++)
+			bf[p][j] = float(b[p][j] = double((p + j * 3) % 13) - 6);
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++) {
+			double sum = 0;
+			for (size_t p = 0; p < k; p++)
+				sum += a[i][p] * b[p][j];
+			c[i][j] = sum;
+		}
+	const TDynamicMatrix<double> res = a * b;
+	const TDynamicMatrix<float> resf = af * bf;
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++) {
+			EXPECT_EQ(c[i][j], res[i][j]);
+			EXPECT_EQ(float(c[i][j]), resf[i][j]);
+		}
+}
+
+TEST(TDynamicMatrix, can_evaluate_chained_expression)
+{
+	TDynamicMatrix<int> m1(3), m2(3), m3(3);
+	for (int i = 0; i < size(m1); i++)
+		for (int j = 0; j < size(m1); j++) {
+			m1[i][j] = i;
+			m2[i][j] = j;
+			m3[i][j] = 1;
+		}
+	TDynamicMatrix<int> res = m1 + m2 - m3 * 3;
+
+	TDynamicMatrix<int> m(3);
+	for (int i = 0; i < size(m); i++)
+		for (int j = 0; j < size(m); j++)
+			m[i][j] = i + j - 3;
+	EXPECT_EQ(m, res);
+}
+
+TEST(TDynamicMatrix, can_multiply_expression_by_matrix)
+{
+	TDynamicMatrix<int> m1(2), m2(2);
+	for (int i = 0; i < size(m1); i++)
+		for (int j = 0; j < size(m1); j++) {
+			m1[i][j] = 1;
+			m2[i][j] = i == j;
+		}
+	TDynamicMatrix<int> m(2);
+	for (int i = 0; i < size(m); i++)
+		for (int j = 0; j < size(m); j++)
+			m[i][j] = 6;
+	EXPECT_EQ(m, (m1 + m2) * (m1 + m1));
+	EXPECT_EQ(m1 * 8, (m1 + m1) * (m1 + m1));
+}
+
+TEST(TDynamicMatrix, can_add_matrix_in_place)
+{
+	TDynamicMatrix<int> m1(2), m2(2);
+	for (int i = 0; i < size(m1); i++)
+		for (int j = 0; j < size(m1); j++) {
+			m1[i][j] = i + j;
+			m2[i][j] = 1;
+		}
+	m1 += m2;
+	m1 -= m2 * 2;
+	m1 *= 3;
+	EXPECT_EQ(-3, m1[0][0]);
+	EXPECT_EQ(3, m1[1][1]);
+}
+
+TEST(TDynamicMatrix, can_accumulate_matrix_vector_product)
+{
+	TDynamicMatrix<int> m(2);
+	m[0][0] = 1; m[0][1] = 2;
+	m[1][0] = 3; m[1][1] = 4;
+	TDynamicVector<int> x(2), y(2);
+	x[0] = 1; x[1] = 1;
+	y[0] = 10; y[1] = 20;
+	y += m * x;
+	EXPECT_EQ(13, y[0]);
+	EXPECT_EQ(27, y[1]);
+}
+
+TEST(TDynamicMatrix, can_assign_matrix_vector_product_to_its_operand)
+{
+	TDynamicMatrix<int> m(2);
+	m[0][0] = 1; m[0][1] = 2;
+	m[1][0] = 3; m[1][1] = 4;
+	TDynamicVector<int> x(2);
+	x[0] = 1; x[1] = 1;
+	x = m * x;
+	EXPECT_EQ(3, x[0]);
+	EXPECT_EQ(7, x[1]);
+}
+
+TEST(TDynamicMatrix, can_update_row_in_place)
+{
+	TDynamicMatrix<int> m(2);
+	m[0][0] = 1; m[0][1] = 2;
+	m[1][0] = 3; m[1][1] = 4;
+	m[1] -= m[0] * 3;
+	EXPECT_EQ(0, m[1][0]);
+	EXPECT_EQ(-2, m[1][1]);
+}
+
+TEST(TDynamicMatrix, temporary_product_lends_its_memory_to_sum)
+{
+	TDynamicMatrix<int> m1(2), m2(2);
+	for (int i = 0; i < size(m1); i++)
+		for (int j = 0; j < size(m1); j++) {
+			m1[i][j] = 1;
+			m2[i][j] = i == j;
+		}
+	TDynamicMatrix<int> m(2);
+	for (int i = 0; i < size(m); i++)
+		for (int j = 0; j < size(m); j++)
+			m[i][j] = 1 + (i == j);
+	EXPECT_EQ(m, m1 + m2 * m2);
+	EXPECT_EQ(m1 * 2 - m, m1 * m1 - m);
+	EXPECT_EQ(m1 * 4, (m1 * m1) * 2);
+}
+
+TEST(TDynamicMatrix, can_create_rectangular_matrix)
+{
+	TDynamicMatrix<int> m(3, 5);
+
+	EXPECT_EQ(3, m.rows());
+	EXPECT_EQ(5, m.cols());
+	EXPECT_EQ(5, m[2].size());
+}
+
+TEST(TDynamicMatrix, size_limit_counts_elements_not_sides)
+{
+	ASSERT_ANY_THROW(TDynamicMatrix<int> m(size_t(1) << 20, size_t(1) << 12));
+	ASSERT_ANY_THROW(TDynamicMatrix<int> m(3, 0));
+	ASSERT_NO_THROW(TDynamicMatrix<int> m(MAX_MATRIX_SIZE * 4, 4));
+}
+
+TEST(TDynamicMatrix, matrices_with_different_shapes_are_not_equal)
+{
+	TDynamicMatrix<int> m1(2, 3), m2(3, 2);
+	fill(m1.data(), m1.data() + 6, 0);
+	fill(m2.data(), m2.data() + 6, 0);
+
+	EXPECT_NE(m1, m2);
+	ASSERT_ANY_THROW(m1 + m2);
+}
+
+TEST(TDynamicMatrix, assign_changes_shape)
+{
+	TDynamicMatrix<int> m1(2, 3), m2(4);
+	fill(m1.data(), m1.data() + 6, 7);
+	m2 = m1;
+
+	EXPECT_EQ(2, m2.rows());
+	EXPECT_EQ(3, m2.cols());
+	EXPECT_EQ(m1, m2);
+}
+
+TEST(TDynamicMatrix, can_multiply_rectangular_matrix_by_vector)
+{
+	TDynamicMatrix<int> m(2, 3);
+	TDynamicVector<int> v(3), res(2);
+	for (int j = 0; j < 3; j++) {
+		m[0][j] = j + 1;
+		m[1][j] = 1;
+		v[j] = j;
+	}
+	res[0] = 8;
+	res[1] = 3;
+
+	EXPECT_EQ(res, m * v);
+	ASSERT_ANY_THROW(m * res);
+}
+
+TEST(TDynamicMatrix, product_of_rectangular_matrices_has_proper_shape)
+{
+	const size_t m = 70, k = 45, n = 90;
+	TDynamicMatrix<long long> a(m, k), b(k, n);
+	for (size_t i = 0; i < m; i++)
+		for (size_t p = 0; p < k; p++)
+			a[i][p] = (long long)(i * 3 + p) % 11 - 5;
+	for (size_t p = 0; p < k; p++)
+		for (size_t j = 0; j < n; j++)
+			b[p][j] = (long long)(p + j * 7) % 13 - 6;
+	TDynamicMatrix<long long> c = a * b;
+
+	ASSERT_EQ(m, c.rows());
+	ASSERT_EQ(n, c.cols());
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++) {
+			long long sum = 0;
+			for (size_t p = 0; p < k; p++)
+				sum += a[i][p] * b[p][j];
+			EXPECT_EQ(sum, c[i][j]);
+		}
+	ASSERT_ANY_THROW(a * a);
+}
+
+TEST(TDynamicMatrix, long_rows_start_at_aligned_addresses)
+{
+	TDynamicMatrix<double> m(5, 100);
+
+	EXPECT_EQ(104, m.stride());
+	for (size_t i = 0; i < m.rows(); i++)
+		EXPECT_EQ(0, reinterpret_cast<uintptr_t>(m[i].data()) % 64);
+}
+
+TEST(TDynamicMatrix, operations_skip_row_padding)
+{
+	const size_t r = 40, c = 70;
+	TDynamicMatrix<double> a(r, c), b(r, c), bt(c, r);
+	TDynamicVector<double> x(c);
+	for (size_t i = 0; i < r; i++)
+		for (size_t j = 0; j < c; j++) {
+			a[i][j] = double(i + j);
+			b[i][j] = double(i * j % 5);
+			bt[j][i] = b[i][j];
+		}
+	for (size_t j = 0; j < c; j++)
+		x[j] = double(j % 3);
+	TDynamicMatrix<double> sum = a + b * 2, prod = a * bt;
+	TDynamicVector<double> y = a * x;
+	a -= b;
+
+	ASSERT_NE(c, sum.stride());
+	for (size_t i = 0; i < r; i++) {
+		double yi = 0;
+		for (size_t j = 0; j < c; j++) {
+			EXPECT_EQ(double(i + j) + b[i][j] * 2, sum[i][j]);
+			EXPECT_EQ(double(i + j) - b[i][j], a[i][j]);
+			yi += double(i + j) * x[j];
+		}
+		EXPECT_EQ(yi, y[i]);
+		for (size_t k = 0; k < r; k++) {
+			double p = 0;
+			for (size_t j = 0; j < c; j++)
+				p += double(i + j) * b[k][j];
+			EXPECT_EQ(p, prod[i][k]);
+		}
+	}
+}
+
+// распределитель, считающий выделенные элементы
+template<typename T>
+struct TCountingAllocator
+{
+	typedef T value_type;
+	size_t* counter;
+
+	explicit TCountingAllocator(size_t* c) : counter(c) {}
+	template<typename U>
+	TCountingAllocator(const TCountingAllocator<U>& a) : counter(a.counter) {}
+
+	T* allocate(size_t n)
+	{
+		*counter += n;
+		return std::allocator<T>().allocate(n);
+	}
+	void deallocate(T* p, size_t n)
+	{
+		*counter -= n;
+		std::allocator<T>().deallocate(p, n);
+	}
+	bool operator==(const TCountingAllocator& a) const { return counter == a.counter; }
+	bool operator!=(const TCountingAllocator& a) const { return counter != a.counter; }
+};
+
+TEST(TDynamicMatrix, memory_comes_from_given_allocator)
+{
+	size_t elements = 0;
+	{
+		typedef TDynamicMatrix<int, TCountingAllocator<int>> TCountedMatrix;
+		TCountedMatrix m(3, 4, TCountingAllocator<int>(&elements));
+		fill(m.data(), m.data() + 12, 2);
+		TCountedMatrix m1(m), m2(m);
+
+		EXPECT_EQ(36, elements);
+		m2 = m + m1 * 3;
+		m2 += m;
+		EXPECT_EQ(10, m2[2][3]);
+		EXPECT_EQ(36, elements);
+		TCountedMatrix m3(std::move(m2));
+		EXPECT_EQ(36, elements);
+	}
+	EXPECT_EQ(0, elements);
+}
+
+TEST(TDynamicMatrix, can_create_zero_and_value_filled_matrices)
+{
+	TDynamicMatrix<float> z(3, 100, zero_init);
+	TDynamicMatrix<int> f(4, 2, fill_init, -1);
+
+	for (size_t i = 0; i < z.rows(); i++)
+		for (size_t j = 0; j < z.cols(); j++)
+			EXPECT_EQ(0.0f, z[i][j]);
+	EXPECT_EQ(-1, f[3][1]);
+	ASSERT_ANY_THROW(TDynamicMatrix<int> m(0, 2, zero_init));
+}
+
+TEST(TDynamicMatrix, adopted_buffer_is_not_copied_and_released_by_deleter)
+{
+	int released = 0;
+	int* mem = new int[6]{ 1, 2, 3, 4, 5, 6 };
+	{
+		TDynamicMatrix<int> m(adopt_buffer, mem, 2, 3, [&](int* p) { delete[] p; released++; });
+
+		EXPECT_EQ(mem, m.data());
+		EXPECT_EQ(3, m.stride());
+		EXPECT_EQ(6, m[1][2]);
+		m = m + m;
+		EXPECT_EQ(12, mem[5]);
+	}
+	EXPECT_EQ(1, released);
+}
+
+TEST(TDynamicMatrix, strided_view_of_external_memory_takes_part_in_operations)
+{
+	// 2 x 2 в буфере с шагом строки 3
+	int a[6] = { 1, 2, -1, 3, 4, -1 };
+	TMatrixView<int> va(a, 2, 2, 3);
+	TMatrixView<const int> vc(a, 2, 2, 3);
+	TDynamicMatrix<int> id(2, 2, zero_init);
+	id[0][0] = id[1][1] = 1;
+	TDynamicVector<int> x(2, fill_init, 1);
+
+	EXPECT_EQ(va, va * id);
+	TDynamicVector<int> y = vc * x;
+	EXPECT_EQ(7, y[1]);
+	TDynamicMatrix<int> s = va + id;
+	EXPECT_EQ(5, s[1][1]);
+	va += id;
+	EXPECT_EQ(5, a[4]);
+	EXPECT_EQ(-1, a[2]);
+	EXPECT_EQ(-1, a[5]);
+	ASSERT_ANY_THROW(TMatrixView<int>(a, 2, 4, 3));
+	ASSERT_ANY_THROW(va = TDynamicMatrix<int>(3));
+}
+
+TEST(TDynamicMatrix, submatrix_view_writes_through_to_matrix)
+{
+	TDynamicMatrix<int> m(4, 5, zero_init);
+	TDynamicMatrix<int> b(2, 3, fill_init, 2);
+	auto s = m.submatrix(1, 2, 2, 3);
+
+	s += b;
+	s -= b * 1 - b;
+	EXPECT_EQ(2, m[1][2]);
+	EXPECT_EQ(2, m[2][4]);
+	EXPECT_EQ(0, m[1][1]);
+	EXPECT_EQ(0, m[3][2]);
+	EXPECT_EQ(b, s);
+	m.row_range(3, 1) = m.row_range(1, 1);
+	EXPECT_EQ(2, m[3][3]);
+	ASSERT_ANY_THROW(m.submatrix(3, 0, 2, 1));
+	ASSERT_ANY_THROW(m.submatrix(0, 3, 1, 3));
+}
+
+TEST(TDynamicMatrix, overlapping_views_are_read_before_writing)
+{
+	TDynamicMatrix<int> m(3, 2);
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 2; j++)
+			m[i][j] = int(10 * i + j);
+	TDynamicMatrix<int> expected(m);
+	expected[2][0] = 10;
+	expected[2][1] = 11;
+	expected[1][0] = 0;
+	expected[1][1] = 1;
+
+	m.row_range(1, 2) = m.row_range(0, 2);
+	EXPECT_EQ(expected, m);
+
+	const size_t n = 5;
+	TDynamicMatrix<int> s(n);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++)
+			s[i][j] = int(i * n + j);
+	TDynamicMatrix<int> copy(s), sum(s);
+	TDynamicMatrix<int> tmp = s.submatrix(0, 0, 3, 3);
+	copy.submatrix(1, 1, 3, 3) = tmp;
+	sum.submatrix(1, 1, 3, 3) += tmp;
+	TDynamicMatrix<int> t(s);
+	t.submatrix(1, 1, 3, 3) = t.submatrix(0, 0, 3, 3);
+	EXPECT_EQ(copy, t);
+	t = s;
+	t.submatrix(1, 1, 3, 3) += t.submatrix(0, 0, 3, 3);
+	EXPECT_EQ(sum, t);
+	t = s;
+	t.submatrix(0, 0, 3, 3) -= t.submatrix(1, 1, 3, 3) * 1;
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 3; j++)
+			EXPECT_EQ(-int(n + 1), t[i][j]);
+}
+
+TEST(TDynamicMatrix, product_of_blocks_equals_product_of_copies)
+{
+	const size_t n = 70;
+	TDynamicMatrix<double> a(n), b(n);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n; j++) {
+			a[i][j] = double(i + 2 * j) / n;
+			b[i][j] = double(3 * i - j) / n;
+		}
+	TDynamicMatrix<double> a1(40, 30), b1(30, 20);
+	for (size_t i = 0; i < 40; i++)
+		for (size_t j = 0; j < 30; j++)
+			a1[i][j] = a[i + 5][j + 10];
+	for (size_t i = 0; i < 30; i++)
+		for (size_t j = 0; j < 20; j++)
+			b1[i][j] = b[i + 1][j + 2];
+
+	EXPECT_EQ(a1 * b1, a.submatrix(5, 10, 40, 30) * b.submatrix(1, 2, 30, 20));
+	// шаг обновления блочного алгоритма: A22 -= A21 * A12 без копий блоков
+	TDynamicMatrix<double> a22 = a.submatrix(30, 30, 40, 40) - a.submatrix(30, 0, 40, 30) * a.submatrix(0, 30, 30, 40);
+	a.submatrix(30, 30, 40, 40) -= a.submatrix(30, 0, 40, 30) * a.submatrix(0, 30, 30, 40);
+	EXPECT_EQ(a22, a.submatrix(30, 30, 40, 40));
+}
+
+TEST(TDynamicMatrix, column_and_diagonal_views)
+{
+	TDynamicMatrix<int> m(3, 4);
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 4; j++)
+			m[i][j] = int(10 * i + j);
+	const TDynamicMatrix<int>& cm = m;
+
+	EXPECT_EQ(3, m.column(1).size());
+	EXPECT_EQ(21, cm.column(1)[2]);
+	EXPECT_EQ(22, m.diagonal()[2]);
+	EXPECT_EQ(2, m.diagonal(2).size());
+	EXPECT_EQ(13, m.diagonal(2)[1]);
+	EXPECT_EQ(21, m.diagonal(-1)[1]);
+	EXPECT_EQ(0 * 3 + 10 * 13 + 20 * 23, m.column(0) * cm.column(3));
+	m.column(3) += m.column(0);
+	EXPECT_EQ(43, m[2][3]);
+	m.diagonal() *= 0;
+	EXPECT_EQ(0, m[1][1]);
+	EXPECT_EQ(12, m[1][2]);
+	ASSERT_ANY_THROW(m.column(4));
+	ASSERT_ANY_THROW(m.diagonal(4));
+	ASSERT_ANY_THROW(m.diagonal(-3));
+}
+
+template<typename T>
+void check_transpose(size_t m, size_t n)
+{
+	TDynamicMatrix<T> a(m, n);
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++)
+			a[i][j] = T(i * 1000 + j);
+	TDynamicMatrix<T> t = transpose(a);
+
+	ASSERT_EQ(n, t.rows());
+	ASSERT_EQ(m, t.cols());
+	for (size_t i = 0; i < m; i++)
+		for (size_t j = 0; j < n; j++)
+			ASSERT_EQ(a[i][j], t[j][i]);
+	EXPECT_EQ(a, transpose(t));
+}
+
+TEST(TDynamicMatrix, transpose_of_any_shape_and_type)
+{
+	check_transpose<double>(1, 1);
+	check_transpose<double>(8, 8);
+	check_transpose<double>(67, 45);
+	check_transpose<float>(13, 80);
+	check_transpose<int>(40, 9);
+	check_transpose<int64_t>(100, 33);
+	check_transpose<short>(17, 19);
+}
+
+TEST(TDynamicMatrix, transpose_of_expression_and_block)
+{
+	TDynamicMatrix<int> a(10, 20, fill_init, 1);
+	a[2][15] = 5;
+	TDynamicMatrix<int> t = transpose(a + a);
+
+	EXPECT_EQ(10, t[15][2]);
+	EXPECT_EQ(2, t[0][0]);
+	TDynamicMatrix<int> s = transpose(a.submatrix(1, 10, 3, 8));
+	EXPECT_EQ(8, s.rows());
+	EXPECT_EQ(5, s[5][1]);
+}
+
+TEST(TDynamicMatrix, can_transpose_square_matrix_in_place)
+{
+	for (size_t n : { 1, 8, 33, 70 }) {
+		TDynamicMatrix<double> a(n);
+		for (size_t i = 0; i < n; i++)
+			for (size_t j = 0; j < n; j++)
+				a[i][j] = double(i * 100 + j);
+		TDynamicMatrix<double> t = transpose(a);
+		a.transpose_inplace();
+		EXPECT_EQ(t, a);
+	}
+	TDynamicMatrix<std::string> s(3);
+	s[0][2] = "x";
+	s.transpose_inplace();
+	EXPECT_EQ("x", s[2][0]);
+	EXPECT_EQ("", s[0][2]);
+
+	TDynamicMatrix<int> r(3, 4);
+	ASSERT_ANY_THROW(r.transpose_inplace());
+	ASSERT_NO_THROW(r.submatrix(0, 1, 3, 3).transpose_inplace());
+}
+
+TEST(TDynamicMatrix, matrix_vector_product_handles_row_and_column_tails)
+{
+	for (size_t m : { 1, 4, 7, 38 })
+		for (size_t n : { 1, 15, 67 }) {
+			TDynamicMatrix<int64_t> a(m, n);
+			TDynamicVector<int64_t> x(n), y(m, fill_init, 1);
+			for (size_t i = 0; i < m; i++)
+				for (size_t j = 0; j < n; j++)
+					a[i][j] = int64_t(i * 3) - int64_t(j);
+			for (size_t j = 0; j < n; j++)
+				x[j] = int64_t(j % 5);
+			TDynamicVector<int64_t> ax = a * x;
+			y -= a * x;
+			for (size_t i = 0; i < m; i++) {
+				int64_t sum = 0;
+				for (size_t j = 0; j < n; j++)
+					sum += a[i][j] * x[j];
+				ASSERT_EQ(sum, ax[i]);
+				ASSERT_EQ(1 - sum, y[i]);
+			}
+		}
+}
+
+TEST(TDynamicMatrix, vector_matrix_product_equals_product_with_transpose)
+{
+	for (size_t m : { 1, 6, 41 })
+		for (size_t n : { 3, 19, 1100 }) {
+			TDynamicMatrix<int> a(m, n);
+			TDynamicVector<int> x(m);
+			for (size_t i = 0; i < m; i++) {
+				x[i] = int(i % 4) - 1;
+				for (size_t j = 0; j < n; j++)
+					a[i][j] = int((i + 2 * j) % 9);
+			}
+			TDynamicVector<int> expected = transpose(a) * x;
+			TDynamicVector<int> y = x * a;
+			EXPECT_EQ(expected, y);
+			y += x * a;
+			EXPECT_EQ(expected * 2, y);
+			y -= x * a;
+			EXPECT_EQ(expected, y);
+			// внутри выражения - поэлементно
+			TDynamicVector<int> z = x * a + y;
+			EXPECT_EQ(expected * 2, z);
+		}
+	TDynamicMatrix<int> a(3, 4);
+	TDynamicVector<int> x(4);
+	ASSERT_ANY_THROW(x * a);
 }
\ No newline at end of file
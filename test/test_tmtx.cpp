@@ -0,0 +1,110 @@
+#include "tmatrix_mtx.h"
+
+#include <gtest.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+static TDynamicMatrix<double> parse_mtx(const std::string& text)
+{
+	return parse_matrix_market<double>(text.data(), text.data() + text.size());
+}
+
+TEST(TMatrixMarket, can_read_general_array_by_columns)
+{
+	TDynamicMatrix<double> m = parse_mtx(
+		"%%MatrixMarket matrix array real general\n"
+		"% comment\n"
+		"2 3\n"
+		"1\n4\n2\n5\n3\n6.5\n");
+
+	ASSERT_EQ(2, m.rows());
+	ASSERT_EQ(3, m.cols());
+	EXPECT_EQ(2, m[0][1]);
+	EXPECT_EQ(4, m[1][0]);
+	EXPECT_EQ(6.5, m[1][2]);
+}
+
+TEST(TMatrixMarket, can_read_symmetric_and_skew_arrays)
+{
+	TDynamicMatrix<double> s = parse_mtx("%%MatrixMarket matrix array real symmetric\n2 2\n1\n2\n3\n");
+	TDynamicMatrix<double> k = parse_mtx("%%MatrixMarket matrix array real skew-symmetric\n2 2\n5\n");
+
+	EXPECT_EQ(2, s[0][1]);
+	EXPECT_EQ(2, s[1][0]);
+	EXPECT_EQ(3, s[1][1]);
+	EXPECT_EQ(5, k[1][0]);
+	EXPECT_EQ(-5, k[0][1]);
+	EXPECT_EQ(0, k[0][0]);
+}
+
+TEST(TMatrixMarket, can_read_coordinate_matrix)
+{
+	TDynamicMatrix<double> m = parse_mtx(
+		"%%MatrixMarket Matrix Coordinate Real General\r\n"
+		"3 2 4\r\n"
+		"1 1 1.5\r\n"
+		"3 2 -2\r\n"
+		"\r\n"
+		"1 1 1\r\n"
+		"2 1 7\r\n");
+
+	ASSERT_EQ(3, m.rows());
+	ASSERT_EQ(2, m.cols());
+	EXPECT_EQ(2.5, m[0][0]); // повторы складываются
+	EXPECT_EQ(7, m[1][0]);
+	EXPECT_EQ(-2, m[2][1]);
+	EXPECT_EQ(0, m[0][1]);
+}
+
+TEST(TMatrixMarket, can_read_symmetric_pattern_coordinates)
+{
+	const std::string text = "%%MatrixMarket matrix coordinate pattern symmetric\n3 3 2\n2 1\n3 3\n";
+	TDynamicMatrix<int> m = parse_matrix_market<int>(text.data(), text.data() + text.size());
+
+	EXPECT_EQ(1, m[1][0]);
+	EXPECT_EQ(1, m[0][1]);
+	EXPECT_EQ(1, m[2][2]);
+	EXPECT_EQ(0, m[1][1]);
+}
+
+TEST(TMatrixMarket, rejects_malformed_files)
+{
+	ASSERT_ANY_THROW(parse_mtx("%%MatrixMarket matrix array complex general\n1 1\n1 0\n"));
+	ASSERT_ANY_THROW(parse_mtx("%%MatrixMarket vector array real general\n1 1\n1\n"));
+	ASSERT_ANY_THROW(parse_mtx("%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n"));
+	ASSERT_ANY_THROW(parse_mtx("%%MatrixMarket matrix coordinate real general\n2 2 2\n1 1 1\n"));
+	ASSERT_ANY_THROW(parse_mtx("%%MatrixMarket matrix coordinate real general\n2 2 1\n3 1 1\n"));
+	ASSERT_ANY_THROW(parse_mtx("%%MatrixMarket matrix coordinate real general\n2 2 1\n1 1 x\n"));
+	ASSERT_ANY_THROW(parse_mtx("%%MatrixMarket matrix coordinate real symmetric\n2 3 0\n"));
+}
+
+TEST(TMatrixMarket, written_matrix_can_be_read_back)
+{
+	TDynamicMatrix<double> a(3, 4, zero_init);
+	a[0][0] = 0.1;
+	a[1][3] = -1.0 / 3;
+	a[2][1] = 1e-300;
+	std::stringstream dense, sparse;
+
+	save_matrix_market(dense, a);
+	save_matrix_market(sparse, a, MTX_COORDINATE);
+	EXPECT_EQ(0u, sparse.str().find("%%MatrixMarket matrix coordinate real general\n3 4 3\n1 1 0.1\n"));
+	EXPECT_EQ(a, read_matrix_market<double>(dense));
+	EXPECT_EQ(a, read_matrix_market<double>(sparse));
+}
+
+TEST(TMatrixMarket, can_save_and_load_file)
+{
+	const char* path = "test_tmtx.tmp";
+	TDynamicMatrix<int> a(2, 3);
+	for (size_t i = 0; i < 2; i++)
+		for (size_t j = 0; j < 3; j++)
+			a[i][j] = int(i * 3 + j) - 2;
+
+	save_matrix_market(path, a * 2);
+	TDynamicMatrix<int> res = load_matrix_market<int>(path);
+	std::remove(path);
+	EXPECT_EQ(a * 2, res);
+}
\ No newline at end of file
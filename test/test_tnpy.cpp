@@ -0,0 +1,128 @@
+#include "tmatrix_npy.h"
+
+#include <gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// заголовок .npy версии 1.0 со словарём dict
+static std::string npy_header(const std::string& dict)
+{
+	std::string h = dict;
+	while ((10 + h.size() + 1) % 64 != 0)
+		h += ' ';
+	h += '\n';
+	return std::string("\x93NUMPY\x01\x00", 8) + char(h.size() & 0xFF) + char(h.size() >> 8) + h;
+}
+
+TEST(TNpyFormat, matrix_and_vector_survive_stream_round_trip)
+{
+	TDynamicMatrix<double> a(3, 100);
+	TDynamicVector<int16_t> v(7);
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 100; j++)
+			a[i][j] = double(i) - double(j) / 8;
+	for (size_t i = 0; i < 7; i++)
+		v[i] = int16_t(i * 1000);
+	std::stringstream sa(std::ios::in | std::ios::out | std::ios::binary);
+	std::stringstream sv(std::ios::in | std::ios::out | std::ios::binary);
+
+	save_npy(sa, a);
+	save_npy(sv, v);
+	const std::string text = sa.str();
+	EXPECT_EQ(0, text.compare(0, 8, std::string("\x93NUMPY\x01\x00", 8)));
+	EXPECT_NE(std::string::npos, text.find("{'descr': '<f8', 'fortran_order': False, 'shape': (3, 100), }"));
+	EXPECT_EQ(0u, (text.size() - a.rows() * a.cols() * sizeof(double)) % 64);
+	EXPECT_NE(std::string::npos, sv.str().find("'shape': (7,)"));
+	EXPECT_EQ(a, load_npy_matrix<double>(sa));
+	EXPECT_EQ(v, load_npy_vector<int16_t>(sv));
+}
+
+TEST(TNpyFormat, reads_fortran_order_and_foreign_byte_order)
+{
+	// 2 x 3 по столбцам, big-endian int32: [[1, 2, 3], [4, 5, 6]]
+	std::string text = npy_header("{'descr': '>i4', 'fortran_order': True, 'shape': (2, 3), }");
+	const int order[6] = { 1, 4, 2, 5, 3, 6 };
+	for (int x : order)
+		text += std::string("\0\0\0", 3) + char(x);
+	std::istringstream s(text);
+
+	TDynamicMatrix<int32_t> m = load_npy_matrix<int32_t>(s);
+	ASSERT_EQ(2, m.rows());
+	ASSERT_EQ(3, m.cols());
+	EXPECT_EQ(2, m[0][1]);
+	EXPECT_EQ(4, m[1][0]);
+	EXPECT_EQ(6, m[1][2]);
+}
+
+TEST(TNpyFormat, rejects_unsupported_arrays)
+{
+	const std::string data(64, '\0');
+	const std::string bad[] = {
+		npy_header("{'descr': '<f8', 'fortran_order': False, 'shape': (2, 2, 2), }") + data,
+		npy_header("{'descr': '|b1', 'fortran_order': False, 'shape': (4,), }") + data,
+		npy_header("{'descr': '<f8', 'fortran_order': False, 'shape': (), }") + data,
+		npy_header("{'descr': '<f8', 'fortran_order': False, 'shape': (100,), }") + data,
+		std::string("NUMPY\x01\x00", 7) + data
+	};
+	for (const std::string& text : bad) {
+		std::istringstream s(text);
+		ASSERT_ANY_THROW(load_npy_vector<double>(s));
+	}
+	std::istringstream s(npy_header("{'descr': '<f4', 'fortran_order': False, 'shape': (4,), }") + data);
+	ASSERT_ANY_THROW(load_npy_vector<double>(s));
+}
+
+TEST(TNpyFormat, can_map_file_without_copying)
+{
+	const char* path = "test_tnpy.npy";
+	TDynamicMatrix<float> a(4, 5);
+	for (size_t i = 0; i < 4; i++)
+		for (size_t j = 0; j < 5; j++)
+			a[i][j] = float(i * 5 + j);
+	save_npy(path, a);
+
+	{
+		TDynamicMatrix<float> m = map_npy_matrix<float>(path);
+		EXPECT_EQ(a, m);
+		m[0][0] = 100; // запись не меняет файл
+		EXPECT_EQ(a, load_npy_matrix<float>(path));
+		ASSERT_ANY_THROW(map_npy_vector<float>(path));
+	}
+	std::remove(path);
+}
+
+TEST(TNpyFormat, npz_archive_can_be_written_and_read)
+{
+	const char* path = "test_tnpy.npz";
+	TDynamicMatrix<double> a(3, 2);
+	TDynamicVector<int64_t> v(10);
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 2; j++)
+			a[i][j] = 0.25 * double(i + j);
+	for (size_t i = 0; i < 10; i++)
+		v[i] = int64_t(i) << 40;
+	{
+		TNpzWriter w(path);
+		w.add("a", a);
+		w.add("v", v);
+		w.add("twice", a * 2.0);
+	}
+
+	EXPECT_EQ(a, load_npz_matrix<double>(path, "a"));
+	EXPECT_EQ(a * 2.0, map_npz_matrix<double>(path, "twice"));
+	EXPECT_EQ(v, map_npz_vector<int64_t>(path, "v"));
+	ASSERT_ANY_THROW(load_npz_matrix<double>(path, "b"));
+	ASSERT_ANY_THROW(load_npz_vector<double>(path, "v"));
+	std::remove(path);
+}
+
+TEST(TNpyFormat, crc32_of_check_string)
+{
+	EXPECT_EQ(0xCBF43926u, tmatrix_detail::crc32_update(0, "123456789", 9));
+	uint32_t crc = tmatrix_detail::crc32_update(0, "12345", 5);
+	EXPECT_EQ(0xCBF43926u, tmatrix_detail::crc32_update(crc, "6789", 4));
+}
\ No newline at end of file
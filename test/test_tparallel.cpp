@@ -0,0 +1,209 @@
+#include "tmatrix.h"
+#include "tutmatrix.h"
+#include "tmatrix_mtx.h"
+#include "tmatrix_compressed.h"
+
+#include <gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// включает параллельное выполнение на время теста
+class TParallelTest : public ::testing::Test
+{
+protected:
+	size_t threads, threshold;
+
+	void SetUp()
+	{
+		TThreadPool& pool = TThreadPool::instance();
+		threads = pool.num_threads();
+		threshold = pool.threshold();
+		pool.set_num_threads(4);
+		pool.set_threshold(0);
+	}
+	void TearDown()
+	{
+		TThreadPool& pool = TThreadPool::instance();
+		pool.set_num_threads(threads);
+		pool.set_threshold(threshold);
+	}
+};
+
+TEST_F(TParallelTest, parallel_for_visits_every_index_once)
+{
+	std::vector<std::atomic<int>> hits(1000);
+	TThreadPool::instance().parallel_for(hits.size(), 1, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++)
+			hits[i]++;
+	});
+	for (size_t i = 0; i < hits.size(); i++)
+		EXPECT_EQ(1, hits[i]);
+}
+
+TEST_F(TParallelTest, parallel_for_rethrows_exception_from_task)
+{
+	ASSERT_ANY_THROW(TThreadPool::instance().parallel_for(100, 1, [](size_t b, size_t e) {
+		if (b <= 50 && 50 < e)
+			throw out_of_range("task failed");
+	}));
+}
+
+TEST_F(TParallelTest, parallel_for_runs_nested_calls)
+{
+	std::atomic<int> sum(0);
+	TThreadPool::instance().parallel_for(10, 1, [&](size_t b, size_t e) {
+		for (size_t i = b; i < e; i++)
+			TThreadPool::instance().parallel_for(10, 1, [&](size_t b2, size_t e2) {
+				sum += int(e2 - b2);
+			});
+	});
+	EXPECT_EQ(100, sum);
+}
+
+TEST_F(TParallelTest, can_run_parallel_matrix_operations)
+{
+	const int n = 70;
+	TDynamicMatrix<int> m1(n), m2(n), sum(n), prod(n);
+	TDynamicVector<int> x(n), y(n);
+	for (int i = 0; i < n; i++) {
+		x[i] = i % 3;
+		for (int j = 0; j < n; j++) {
+			m1[i][j] = (i + j) % 5;
+			m2[i][j] = (i * j) % 7;
+			sum[i][j] = m1[i][j] * 2 + m2[i][j];
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		int s = 0;
+		for (int j = 0; j < n; j++) {
+			int p = 0;
+			for (int k = 0; k < n; k++)
+				p += m1[i][k] * m2[k][j];
+			prod[i][j] = p;
+			s += m1[i][j] * x[j];
+		}
+		y[i] = s;
+	}
+	EXPECT_EQ(sum, m1 * 2 + m2);
+	EXPECT_EQ(prod, m1 * m2);
+	EXPECT_EQ(y, m1 * x);
+}
+
+TEST_F(TParallelTest, parallel_upper_triangular_operations_match_dense_ones)
+{
+	const size_t n = 61;
+	TUpperTriangularMatrix<int> a(n), b(n);
+	TDynamicVector<int> x(n);
+	for (size_t i = 0; i < n; i++) {
+		x[i] = int(i % 3) - 1;
+		for (size_t j = i; j < n; j++) {
+			a(i, j) = int((i + j) % 5);
+			b(i, j) = int((i * j) % 7);
+		}
+	}
+	EXPECT_EQ(a.to_dense() * b.to_dense(), (a * b).to_dense());
+	EXPECT_EQ(a.to_dense() * x, a * x);
+}
+
+TEST_F(TParallelTest, parallel_transpose_matches_elementwise_one)
+{
+	const size_t n = 150;
+	TDynamicMatrix<double> a(n, n + 7);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n + 7; j++)
+			a[i][j] = double(i) - double(j) / 1000;
+	TDynamicMatrix<double> t = transpose(a);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j < n + 7; j++)
+			ASSERT_EQ(a[i][j], t[j][i]);
+
+	TDynamicMatrix<double> sq = a.submatrix(0, 0, n, n);
+	sq.transpose_inplace();
+	EXPECT_EQ(transpose(a.submatrix(0, 0, n, n)), sq);
+}
+
+TEST_F(TParallelTest, parallel_matrix_vector_products_match_serial_ones)
+{
+	const size_t m = 203, n = 2500;
+	TDynamicMatrix<double> a(m, n);
+	TDynamicVector<double> x(n), u(m);
+	for (size_t i = 0; i < m; i++) {
+		u[i] = double(i % 3);
+		for (size_t j = 0; j < n; j++)
+			a[i][j] = double((i * 7 + j) % 11);
+	}
+	for (size_t j = 0; j < n; j++)
+		x[j] = double(j % 4);
+
+	TDynamicVector<double> y = a * x;
+	TDynamicVector<double> z = u * a;
+	for (size_t i = 0; i < m; i++) {
+		double sum = 0;
+		for (size_t j = 0; j < n; j++)
+			sum += a[i][j] * x[j];
+		ASSERT_EQ(sum, y[i]);
+	}
+	for (size_t j = 0; j < n; j++) {
+		double sum = 0;
+		for (size_t i = 0; i < m; i++)
+			sum += u[i] * a[i][j];
+		ASSERT_EQ(sum, z[j]);
+	}
+}
+
+TEST_F(TParallelTest, parallel_text_parsing_keeps_row_order)
+{
+	// несколько кусков по TEXT_CHUNK_MIN байтов
+	const size_t n = 300000;
+	std::string text;
+	for (size_t i = 0; i < n; i++)
+		text += std::to_string(i) + ' ' + std::to_string(i % 7) + ".5\n";
+	ASSERT_GT(text.size(), 2 * tmatrix_detail::TEXT_CHUNK_MIN);
+
+	TDynamicMatrix<double> m = parse_text_matrix<double>(text.data(), text.data() + text.size());
+	TDynamicVector<double> v = parse_text_vector<double>(text.data(), text.data() + text.size());
+	ASSERT_EQ(n, m.rows());
+	ASSERT_EQ(2 * n, v.size());
+	for (size_t i = 0; i < n; i++) {
+		ASSERT_EQ(double(i), m[i][0]);
+		ASSERT_EQ(double(i % 7) + 0.5, m[i][1]);
+		ASSERT_EQ(double(i), v[2 * i]);
+	}
+}
+
+TEST_F(TParallelTest, parallel_matrix_market_parsing)
+{
+	const size_t n = 1000, entries = 200000;
+	std::string text = "%%MatrixMarket matrix coordinate integer general\n"
+		+ std::to_string(n) + ' ' + std::to_string(n) + ' ' + std::to_string(entries) + '\n';
+	TDynamicMatrix<int64_t> expected(n, n, zero_init);
+	for (size_t k = 0; k < entries; k++) {
+		const size_t i = k * 7919 % n, j = k * 104729 % n;
+		text += std::to_string(i + 1) + ' ' + std::to_string(j + 1) + ' ' + std::to_string(k) + '\n';
+		expected[i][j] += int64_t(k);
+	}
+	ASSERT_GT(text.size(), 2 * tmatrix_detail::TEXT_CHUNK_MIN);
+
+	EXPECT_EQ(expected, parse_matrix_market<int64_t>(text.data(), text.data() + text.size()));
+}
+
+TEST_F(TParallelTest, parallel_block_compression)
+{
+	const char* path = "test_tparallel.tmz";
+	const size_t n = 500;
+	TDynamicMatrix<int64_t> a(n, n, zero_init);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = i % 9; j < n; j += 9)
+			a[i][j] = int64_t(i * n + j);
+	save_compressed(path, a, 16);
+
+	TCompressedMatrixReader<int64_t> r(path);
+	EXPECT_EQ(a, r.read());
+	TDynamicMatrix<int64_t> part = r.read_rows(37, 400);
+	for (size_t i = 0; i < 400; i++)
+		ASSERT_EQ(a[37 + i][(37 + i) % 9], part[i][(37 + i) % 9]);
+	std::remove(path);
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "tmatrix.h"
+
+#include <gtest.h>
+
+#include <thread>
+#include <vector>
+
+TEST(TBufferPool, repeated_operations_reuse_buffers)
+{
+	if (!TBufferPool::is_enabled())
+		return; // TMATRIX_POOL=0
+	TDynamicMatrix<double> a(64, 48), b(64, 48);
+	fill(a.data(), a.data() + a.rows() * a.stride(), 1.0);
+	fill(b.data(), b.data() + b.rows() * b.stride(), 2.0);
+	TDynamicVector<double> x(48, fill_init, 1.0);
+
+	TDynamicVector<double> y(64, zero_init);
+	auto step = [&]() {
+		TDynamicMatrix<double> tmp = a + b * 2.0;
+		TDynamicVector<double> v = tmp * x;
+		y = v + y;
+	};
+	step();
+	const size_t before = TBufferPool::system_allocations();
+	for (int it = 0; it < 100; it++)
+		step();
+
+	EXPECT_EQ(before, TBufferPool::system_allocations());
+	EXPECT_EQ(101 * 48 * 5.0, y[7]);
+}
+
+TEST(TBufferPool, buffer_freed_in_other_thread_is_reused)
+{
+	if (!TBufferPool::is_enabled())
+		return; // TMATRIX_POOL=0
+	TBufferPool::trim();
+	const size_t n = 12345;
+	TDynamicVector<int>* v = new TDynamicVector<int>(n);
+	const int* mem = v->data();
+	std::thread t([v]() { delete v; });
+	t.join();
+
+	const size_t before = TBufferPool::system_allocations();
+	TDynamicVector<int> w(n);
+	EXPECT_EQ(mem, w.data());
+	EXPECT_EQ(before, TBufferPool::system_allocations());
+}
+
+TEST(TBufferPool, disabled_pool_allocates_from_system)
+{
+	const bool enabled = TBufferPool::is_enabled();
+	TBufferPool::set_enabled(false);
+	const size_t before = TBufferPool::system_allocations();
+	{
+		TDynamicVector<int> v(100);
+	}
+	TDynamicVector<int> v(100, zero_init);
+	EXPECT_EQ(before + 2, TBufferPool::system_allocations());
+	EXPECT_EQ(0, v[99]);
+	TBufferPool::set_enabled(enabled);
+}
+
+TEST(TBufferPool, large_buffers_beyond_limit_return_to_system)
+{
+	if (!TBufferPool::is_enabled())
+		return; // TMATRIX_POOL=0
+	TBufferPool::trim();
+	const size_t n = 6000000; // 48 Мбайт
+	const size_t count = 12;
+	{
+		std::vector<TDynamicVector<double>> v;
+		for (size_t i = 0; i < count; i++)
+			v.emplace_back(n);
+	}
+	// кэш потока (64 Мбайт) и общий список (256 Мбайт) вмещают не все
+	const size_t retained = TBufferPool::retained_bytes();
+	EXPECT_LT(0u, retained);
+	EXPECT_GE((size_t(64) << 20) + (size_t(256) << 20), retained);
+
+	const size_t kept = retained / (n * sizeof(double));
+	const size_t before = TBufferPool::system_allocations();
+	{
+		std::vector<TDynamicVector<double>> v;
+		for (size_t i = 0; i < count; i++)
+			v.emplace_back(n);
+	}
+	EXPECT_EQ(before + count - kept, TBufferPool::system_allocations());
+	TBufferPool::trim();
+	EXPECT_EQ(0u, TBufferPool::retained_bytes());
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "tmatrix_text.h"
+#include "tutmatrix.h"
+
+#include <gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+TEST(TTextInput, stream_input_reads_numbers_and_stops_after_last_one)
+{
+	std::istringstream in("1 +2\t-3\n4e1 0.5 .25\n  7 tail");
+	TDynamicMatrix<double> m(2, 3);
+	int k;
+	std::string rest;
+
+	in >> m >> k >> rest;
+	EXPECT_EQ(2, m[0][1]);
+	EXPECT_EQ(-3, m[0][2]);
+	EXPECT_EQ(40, m[1][0]);
+	EXPECT_EQ(0.25, m[1][2]);
+	EXPECT_EQ(7, k);
+	EXPECT_EQ("tail", rest);
+}
+
+TEST(TTextInput, stream_input_sets_failbit_on_bad_number)
+{
+	TDynamicVector<int> v(3);
+	std::istringstream bad("1 2x 3"), shortInput("1 2");
+
+	bad >> v;
+	EXPECT_TRUE(bad.fail());
+	shortInput >> v;
+	EXPECT_TRUE(shortInput.fail());
+	EXPECT_TRUE(shortInput.eof());
+}
+
+TEST(TTextInput, stream_input_does_not_split_long_number)
+{
+	TDynamicVector<double> v(2);
+	std::istringstream in("0." + std::string(300, '1') + " 2");
+
+	in >> v;
+	EXPECT_TRUE(in.fail());
+}
+
+TEST(TTextInput, stream_input_into_views)
+{
+	TDynamicMatrix<int> m(3, 3, zero_init);
+	std::istringstream in("1 2 3 4 5 6");
+
+	in >> m.column(1) >> m.submatrix(0, 2, 3, 1);
+	EXPECT_EQ(3, m[2][1]);
+	EXPECT_EQ(6, m[2][2]);
+	EXPECT_EQ(0, m[2][0]);
+}
+
+TEST(TTextInput, can_parse_csv_like_matrix)
+{
+	const std::string text = "1, 2;3\r\n\n  4,5 ,6\r\n";
+	TDynamicMatrix<float> m = parse_text_matrix<float>(text.data(), text.data() + text.size());
+
+	ASSERT_EQ(2, m.rows());
+	ASSERT_EQ(3, m.cols());
+	EXPECT_EQ(3, m[0][2]);
+	EXPECT_EQ(5, m[1][1]);
+}
+
+TEST(TTextInput, matrix_parser_rejects_ragged_rows_and_garbage)
+{
+	const std::string ragged = "1 2 3\n4 5\n", garbage = "1 2\n3 z\n", empty = " \n\n";
+
+	ASSERT_ANY_THROW(parse_text_matrix<int>(ragged.data(), ragged.data() + ragged.size()));
+	ASSERT_ANY_THROW(parse_text_matrix<int>(garbage.data(), garbage.data() + garbage.size()));
+	ASSERT_ANY_THROW(parse_text_matrix<int>(empty.data(), empty.data() + empty.size()));
+}
+
+TEST(TTextInput, can_load_matrix_and_vector_from_file)
+{
+	const char* path = "test_ttext.tmp";
+	{
+		std::ofstream out(path);
+		out << "1 2\n3 4\n5 6";
+	}
+	TDynamicMatrix<int64_t> m = load_text_matrix<int64_t>(path);
+	TDynamicVector<double> v = load_text_vector<double>(path);
+	std::remove(path);
+
+	EXPECT_EQ(3, m.rows());
+	EXPECT_EQ(6, m[2][1]);
+	EXPECT_EQ(6, v.size());
+	EXPECT_EQ(4, v[3]);
+}
+
+TEST(TTextOutput, stream_output_layout)
+{
+	TDynamicVector<int> v(3);
+	TDynamicMatrix<int> m(2, 3);
+	for (size_t i = 0; i < 3; i++) {
+		v[i] = int(i) - 1;
+		m[0][i] = int(i);
+		m[1][i] = int(i) * 10;
+	}
+	std::ostringstream out;
+
+	out << v << m << m.column(1);
+	EXPECT_EQ("-1 0 1 0 1 2\n0 10 20\n1 10 ", out.str());
+}
+
+TEST(TTextOutput, expression_output_matches_container_output)
+{
+	TDynamicVector<int> v(3);
+	TDynamicMatrix<int> m(2, 3);
+	for (size_t i = 0; i < 3; i++) {
+		v[i] = int(i) - 1;
+		m[0][i] = int(i);
+		m[1][i] = int(i) * 10;
+	}
+	std::ostringstream expr, evaluated;
+
+	expr << text_format(';') << v + v << m + m;
+	evaluated << text_format(';') << TDynamicVector<int>(v + v) << TDynamicMatrix<int>(m + m);
+	EXPECT_EQ(evaluated.str(), expr.str());
+	EXPECT_EQ("-2;0;2;0;2;4\n0;20;40\n", expr.str());
+}
+
+TEST(TTextOutput, uses_precision_and_float_format_of_stream)
+{
+	TDynamicVector<double> v(2);
+	v[0] = 1.0 / 3;
+	v[1] = 1e10;
+	std::ostringstream general, fixed, sci;
+
+	general << std::setprecision(3) << v;
+	fixed << std::fixed << std::setprecision(2) << v;
+	sci << std::scientific << std::setprecision(1) << v;
+	EXPECT_EQ("0.333 1e+10 ", general.str());
+	EXPECT_EQ("0.33 10000000000.00 ", fixed.str());
+	EXPECT_EQ("3.3e-01 1.0e+10 ", sci.str());
+}
+
+TEST(TTextOutput, text_format_sets_delimiter_and_shortest_precision)
+{
+	TDynamicMatrix<double> m(2, 2);
+	m[0][0] = 0.1;
+	m[0][1] = 1.0 / 3;
+	m[1][0] = -2;
+	m[1][1] = 1e300;
+	std::ostringstream out;
+
+	out << text_format(',', TEXT_SHORTEST) << m;
+	EXPECT_EQ("0.1,0.3333333333333333\n-2,1e+300\n", out.str());
+
+	const std::string text = out.str();
+	EXPECT_EQ(m, parse_text_matrix<double>(text.data(), text.data() + text.size()));
+}
+
+TEST(TTextOutput, falls_back_to_stream_formatting_for_special_flags)
+{
+	TDynamicVector<int> v(2);
+	TDynamicVector<char> c(2);
+	v[0] = 255;
+	v[1] = 16;
+	c[0] = 'a';
+	c[1] = 'b';
+	std::ostringstream out;
+
+	out << std::hex << v << c;
+	EXPECT_EQ("ff 10 a b ", out.str());
+}
+
+TEST(TTextOutput, large_matrix_round_trip_through_buffer)
+{
+	const size_t n = 300; // больше TEXT_BUFFER_SIZE символов
+	TDynamicMatrix<double> m(n, n + 1);
+	for (size_t i = 0; i < n; i++)
+		for (size_t j = 0; j <= n; j++)
+			m[i][j] = double(i) / (j + 1);
+	std::stringstream text;
+
+	text << std::setprecision(17) << m;
+	ASSERT_GT(text.str().size(), tmatrix_detail::TEXT_BUFFER_SIZE);
+	TDynamicMatrix<double> res(n, n + 1);
+	text >> res;
+	EXPECT_EQ(m, res);
+}
+
+TEST(TTextOutput, upper_triangular_output)
+{
+	TUpperTriangularMatrix<int> u(2);
+	u(0, 0) = 1;
+	u(0, 1) = 2;
+	u(1, 1) = 3;
+	std::ostringstream out;
+
+	out << text_format(';') << u;
+	EXPECT_EQ("1;2\n0;3\n", out.str());
+}
\ No newline at end of file
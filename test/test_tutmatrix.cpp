@@ -0,0 +1,113 @@
+#include "tutmatrix.h"
+
+#include <gtest.h>
+
+namespace
+{
+	// верхнетреугольная матрица со значениями base + i * n + j
+	TUpperTriangularMatrix<int> make_upper(size_t n, int base)
+	{
+		TUpperTriangularMatrix<int> m(n);
+		for (size_t i = 0; i < n; i++)
+			for (size_t j = i; j < n; j++)
+				m(i, j) = base + int(i * n + j);
+		return m;
+	}
+}
+
+TEST(TUpperTriangularMatrix, can_create_matrix_with_positive_length)
+{
+	ASSERT_NO_THROW(TUpperTriangularMatrix<int> m(5));
+}
+
+TEST(TUpperTriangularMatrix, cant_create_too_large_matrix)
+{
+	ASSERT_ANY_THROW(TUpperTriangularMatrix<int> m(MAX_MATRIX_SIZE + 1));
+}
+
+TEST(TUpperTriangularMatrix, stores_only_upper_half)
+{
+	TUpperTriangularMatrix<int> m = make_upper(4, 1);
+
+	EXPECT_EQ(4 * 5 / 2, m.row(0).size() + m.row(1).size() + m.row(2).size() + m.row(3).size());
+	EXPECT_EQ(m(1, 1), m.data()[4]);
+	EXPECT_EQ(m(3, 3), m.data()[9]);
+}
+
+TEST(TUpperTriangularMatrix, elements_below_diagonal_are_zero)
+{
+	const TUpperTriangularMatrix<int> m = make_upper(3, 1);
+
+	EXPECT_EQ(0, m(2, 0));
+	EXPECT_EQ(m(0, 2), 3);
+}
+
+TEST(TUpperTriangularMatrix, throws_when_write_below_diagonal)
+{
+	TUpperTriangularMatrix<int> m(3);
+
+	ASSERT_ANY_THROW(m(2, 1) = 1);
+	ASSERT_ANY_THROW(m(3, 3) = 1);
+}
+
+TEST(TUpperTriangularMatrix, copied_matrix_is_equal_to_source_one)
+{
+	TUpperTriangularMatrix<int> m = make_upper(4, 1);
+	TUpperTriangularMatrix<int> m1(m);
+
+	EXPECT_EQ(m, m1);
+	m1(0, 3) = -1;
+	EXPECT_NE(m, m1);
+}
+
+TEST(TUpperTriangularMatrix, can_convert_to_and_from_dense_matrix)
+{
+	TUpperTriangularMatrix<int> m = make_upper(4, 1);
+	TDynamicMatrix<int> d = m.to_dense();
+
+	EXPECT_EQ(0, d[3][0]);
+	EXPECT_EQ(m(1, 2), d[1][2]);
+	d[2][1] = 100;
+	EXPECT_EQ(m, TUpperTriangularMatrix<int>(d));
+}
+
+TEST(TUpperTriangularMatrix, can_add_subtract_and_scale_matrices)
+{
+	TUpperTriangularMatrix<int> a = make_upper(5, 1), b = make_upper(5, 7);
+
+	EXPECT_EQ((a + b).to_dense(), a.to_dense() + b.to_dense());
+	EXPECT_EQ((a - b).to_dense(), a.to_dense() - b.to_dense());
+	EXPECT_EQ((a * 3).to_dense(), a.to_dense() * 3);
+	a += b;
+	a -= b * 2;
+	EXPECT_EQ(a.to_dense(), make_upper(5, 1).to_dense() - b.to_dense());
+}
+
+TEST(TUpperTriangularMatrix, cant_add_matrices_with_not_equal_size)
+{
+	TUpperTriangularMatrix<int> a(4), b(5);
+
+	ASSERT_ANY_THROW(a + b);
+	ASSERT_ANY_THROW(a * b);
+}
+
+TEST(TUpperTriangularMatrix, can_multiply_matrix_by_vector)
+{
+	const size_t n = 37;
+	TUpperTriangularMatrix<int> a = make_upper(n, -50);
+	TDynamicVector<int> x(n);
+	for (size_t i = 0; i < n; i++)
+		x[i] = int(i % 7) - 3;
+	TDynamicVector<int> expected = a.to_dense() * x;
+
+	EXPECT_EQ(expected, a * x);
+}
+
+TEST(TUpperTriangularMatrix, product_of_upper_matrices_matches_dense_product)
+{
+	const size_t n = 37;
+	TUpperTriangularMatrix<int> a = make_upper(n, -50), b = make_upper(n, 3);
+	TUpperTriangularMatrix<int> c = a * b;
+
+	EXPECT_EQ(a.to_dense() * b.to_dense(), c.to_dense());
+}
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include <gtest.h>
 
+#include <string>
+
 TEST(TDynamicVector, can_create_vector_with_positive_length)
 {
 	ASSERT_NO_THROW(TDynamicVector<int> v(5));
@@ -62,14 +64,22 @@ TEST(TDynamicVector, can_set_and_get_element)
 TEST(TDynamicVector, throws_when_set_element_with_negative_index)
 {
 	TDynamicVector<int> v(4);
-	ASSERT_ANY_THROW(v[-1] = 0);
+	ASSERT_ANY_THROW(v.at(-1) = 0);
 }
 
 TEST(TDynamicVector, throws_when_set_element_with_too_large_index)
+{
+	TDynamicVector<int> v(4);
+	ASSERT_ANY_THROW(v.at(4) = 0);
+}
+
+#ifdef TMATRIX_CHECKED_INDEX
+TEST(TDynamicVector, checked_build_throws_from_subscript)
 {
 	TDynamicVector<int> v(4);
 	ASSERT_ANY_THROW(v[4] = 0);
 }
+#endif
 
 TEST(TDynamicVector, can_assign_vector_to_itself)
 {
@@ -232,4 +242,348 @@ TEST(TDynamicVector, cant_multiply_vectors_with_not_equal_size)
 	TDynamicVector<int> v1(2);
 	TDynamicVector<int> v2(4);
 	ASSERT_ANY_THROW(v1 * v2);
+}
+
+template<typename T>
+void check_vector_kernels_against_plain_loops()
+{
+	const int n = 67; // не кратно ширине регистра - проверяется и хвост
+	TDynamicVector<T> a(n), b(n), sum(n), diff(n), scaled(n);
+	T dot = 0;
+	for (int i = 0; i < n; i++) {
+		a[i] = T(i % 9 + 1);
+		b[i] = T(i % 5 - 2);
+		sum[i] = a[i] + b[i];
+		diff[i] = a[i] - b[i];
+		scaled[i] = a[i] * T(3);
+		dot += a[i] * b[i];
+	}
+	EXPECT_EQ(sum, a + b);
+	EXPECT_EQ(diff, a - b);
+	EXPECT_EQ(scaled, a * T(3));
+	EXPECT_EQ(dot, a * b);
+}
+
+TEST(TDynamicVector, simd_kernels_match_plain_loops_for_float)
+{
+	check_vector_kernels_against_plain_loops<float>();
+}
+
+TEST(TDynamicVector, simd_kernels_match_plain_loops_for_double)
+{
+	check_vector_kernels_against_plain_loops<double>();
+}
+
+TEST(TDynamicVector, simd_kernels_match_plain_loops_for_int32)
+{
+	check_vector_kernels_against_plain_loops<int32_t>();
+}
+
+TEST(TDynamicVector, simd_kernels_match_plain_loops_for_int64)
+{
+	check_vector_kernels_against_plain_loops<int64_t>();
+}
+
+TEST(TDynamicVector, int64_kernels_keep_high_bits)
+{
+	TDynamicVector<int64_t> a(9), b(9);
+	for (int i = 0; i < 9; i++) {
+		a[i] = (int64_t(1) << 40) + i;
+		b[i] = -3;
+	}
+	TDynamicVector<int64_t> res = a * int64_t(-3);
+	for (int i = 0; i < 9; i++)
+		EXPECT_EQ(a[i] * -3, res[i]);
+	EXPECT_EQ(-3 * (9 * (int64_t(1) << 40) + 36), a * b);
+}
+
+TEST(TDynamicVector, arithmetic_builds_expression_instead_of_vector)
+{
+	TDynamicVector<int> a(3), b(3);
+	EXPECT_FALSE((is_same<decltype(a + b), TDynamicVector<int>>::value));
+	EXPECT_FALSE((is_same<decltype(a * 2), TDynamicVector<int>>::value));
+}
+
+TEST(TDynamicVector, can_evaluate_chained_expression)
+{
+	TDynamicVector<int> a(4), b(4), c(4);
+	for (int i = 0; i < size(a); i++) {
+		a[i] = i;
+		b[i] = 10 * i;
+		c[i] = 1;
+	}
+	TDynamicVector<int> res = a + b - c * 2;
+
+	TDynamicVector<int> v(4);
+	for (int i = 0; i < size(v); i++)
+		v[i] = 11 * i - 2;
+	EXPECT_EQ(v, res);
+}
+
+TEST(TDynamicVector, can_assign_expression_that_uses_target)
+{
+	TDynamicVector<int> v(3);
+	for (int i = 0; i < size(v); i++)
+		v[i] = i + 1;
+	v = v + v * 2;
+	EXPECT_EQ(3, v[0]);
+	EXPECT_EQ(9, v[2]);
+}
+
+TEST(TDynamicVector, assign_expression_changes_vector_size)
+{
+	TDynamicVector<int> a(5), v(2);
+	for (int i = 0; i < size(a); i++)
+		a[i] = i;
+	v = a + a;
+	EXPECT_EQ(5, v.size());
+	EXPECT_EQ(8, v[4]);
+}
+
+TEST(TDynamicVector, cant_build_expression_from_vectors_with_not_equal_size)
+{
+	TDynamicVector<int> v1(2), v2(3), v3(3);
+	ASSERT_ANY_THROW(v2 + v3 - v1);
+}
+
+TEST(TDynamicVector, can_add_vector_in_place)
+{
+	TDynamicVector<int> v1(3), v2(3);
+	for (int i = 0; i < size(v1); i++) {
+		v1[i] = i;
+		v2[i] = 10;
+	}
+	int* mem = v1.data();
+	v1 += v2;
+	v1 -= v2 * 3;
+	EXPECT_EQ(mem, v1.data());
+	EXPECT_EQ(-20, v1[0]);
+	EXPECT_EQ(-18, v1[2]);
+}
+
+TEST(TDynamicVector, can_multiply_vector_by_scalar_in_place)
+{
+	TDynamicVector<int> v(3);
+	for (int i = 0; i < size(v); i++)
+		v[i] = i;
+	v *= 3;
+	v += 1;
+	EXPECT_EQ(7, v[2]);
+}
+
+TEST(TDynamicVector, cant_add_in_place_vector_with_not_equal_size)
+{
+	TDynamicVector<int> v1(2), v2(3);
+	ASSERT_ANY_THROW(v1 += v2);
+}
+
+TDynamicVector<int> make_filled_vector(int n, int val)
+{
+	TDynamicVector<int> v(n);
+	for (int i = 0; i < n; i++)
+		v[i] = val;
+	return v;
+}
+
+TEST(TDynamicVector, temporary_operand_lends_its_memory_to_result)
+{
+	TDynamicVector<int> v = make_filled_vector(3, 1);
+	TDynamicVector<int> tmp = make_filled_vector(3, 5);
+	int* mem = tmp.data();
+
+	TDynamicVector<int> res = std::move(tmp) - v;
+	EXPECT_EQ(mem, res.data());
+	EXPECT_EQ(make_filled_vector(3, 4), res);
+}
+
+TEST(TDynamicVector, can_use_temporary_operands)
+{
+	TDynamicVector<int> v = make_filled_vector(3, 2);
+	EXPECT_EQ(make_filled_vector(3, 3), make_filled_vector(3, 1) + v);
+	EXPECT_EQ(make_filled_vector(3, -1), v - make_filled_vector(3, 3));
+	EXPECT_EQ(make_filled_vector(3, 5), make_filled_vector(3, 1) + make_filled_vector(3, 4));
+	EXPECT_EQ(make_filled_vector(3, 12), make_filled_vector(3, 4) * 3);
+	EXPECT_EQ(make_filled_vector(3, 6), make_filled_vector(3, 4) + 2);
+}
+
+TEST(TDynamicVector, buffer_is_aligned_to_cache_line)
+{
+	TDynamicVector<double> v(3), v1(v);
+	TDynamicVector<char> c(5);
+
+	EXPECT_EQ(0, reinterpret_cast<uintptr_t>(v.data()) % 64);
+	EXPECT_EQ(0, reinterpret_cast<uintptr_t>(v1.data()) % 64);
+	EXPECT_EQ(0, reinterpret_cast<uintptr_t>(c.data()) % 64);
+}
+
+// распределитель-счётчик: все блоки учитываются в своей "арене"
+struct TArenaStats
+{
+	size_t allocations = 0, live = 0;
+};
+
+template<typename T>
+struct TArenaAllocator
+{
+	typedef T value_type;
+	TArenaStats* arena;
+
+	explicit TArenaAllocator(TArenaStats* a) : arena(a) {}
+	template<typename U>
+	TArenaAllocator(const TArenaAllocator<U>& a) : arena(a.arena) {}
+
+	T* allocate(size_t n)
+	{
+		arena->allocations++;
+		arena->live++;
+		return std::allocator<T>().allocate(n);
+	}
+	void deallocate(T* p, size_t n)
+	{
+		arena->live--;
+		std::allocator<T>().deallocate(p, n);
+	}
+	bool operator==(const TArenaAllocator& a) const { return arena == a.arena; }
+	bool operator!=(const TArenaAllocator& a) const { return arena != a.arena; }
+};
+
+TEST(TDynamicVector, memory_comes_from_given_allocator)
+{
+	TArenaStats arena;
+	{
+		typedef TDynamicVector<int, TArenaAllocator<int>> TArenaVector;
+		TArenaVector v(3, TArenaAllocator<int>(&arena));
+		v[0] = 1; v[1] = 2; v[2] = 3;
+		TArenaVector v1(v);
+		TArenaVector v2(v * 2 + v1, v.get_allocator());
+
+		EXPECT_EQ(3, arena.live);
+		EXPECT_EQ(&arena, v1.get_allocator().arena);
+		EXPECT_EQ(9, v2[2]);
+		v1 = v1 + v;
+		EXPECT_EQ(4, v1[1]);
+	}
+	EXPECT_EQ(0, arena.live);
+}
+
+TEST(TDynamicVector, move_between_different_allocators_copies_elements)
+{
+	TArenaStats a1, a2;
+	{
+		typedef TDynamicVector<int, TArenaAllocator<int>> TArenaVector;
+		TArenaVector v1(2, TArenaAllocator<int>(&a1)), v2(2, TArenaAllocator<int>(&a2));
+		v1[0] = 5; v1[1] = 6;
+		int* mem = v2.data();
+		v2 = std::move(v1);
+
+		EXPECT_EQ(mem, v2.data());
+		EXPECT_EQ(6, v2[1]);
+		EXPECT_EQ(1, a1.live);
+		EXPECT_EQ(1, a2.live);
+	}
+	EXPECT_EQ(0, a1.live + a2.live);
+}
+
+TEST(TDynamicVector, can_create_zero_filled_vector)
+{
+	TDynamicVector<double> v(1000, zero_init);
+	TDynamicVector<std::string> s(3, zero_init);
+
+	for (size_t i = 0; i < v.size(); i++)
+		EXPECT_EQ(0.0, v[i]);
+	EXPECT_EQ("", s[2]);
+}
+
+TEST(TDynamicVector, can_create_vector_filled_with_value)
+{
+	TDynamicVector<int> v(5, fill_init, 7);
+	TDynamicVector<std::string> s(2, fill_init, std::string("ab"));
+
+	EXPECT_EQ(7, v[4]);
+	EXPECT_EQ("ab", s[1]);
+}
+
+TEST(TDynamicVector, can_create_uninitialized_vector)
+{
+	TDynamicVector<int> v(5, uninitialized_init);
+	v = v * 0 + 3;
+
+	EXPECT_EQ(5, v.size());
+	EXPECT_EQ(3, v[4]);
+	ASSERT_ANY_THROW(TDynamicVector<int> v1(0, zero_init));
+}
+
+TEST(TDynamicVector, adopted_buffer_is_not_copied_and_released_by_deleter)
+{
+	int released = 0;
+	double* mem = new double[3]{ 1, 2, 3 };
+	{
+		TDynamicVector<double> v(adopt_buffer, mem, 3, [&](double* p) { delete[] p; released++; });
+		TDynamicVector<double> w(std::move(v));
+
+		EXPECT_EQ(mem, w.data());
+		EXPECT_EQ(6, w * w - 8);
+		w = w + w;
+		EXPECT_EQ(0, released);
+	}
+	EXPECT_EQ(1, released);
+}
+
+TEST(TDynamicVector, view_of_external_memory_takes_part_in_operations)
+{
+	int a[4] = { 1, 2, 3, 4 };
+	const int b[4] = { 4, 3, 2, 1 };
+	TVectorView<int> va(a, 4);
+	TVectorView<const int> vb(b, 4);
+	TDynamicVector<int> v(4, fill_init, 1);
+
+	EXPECT_EQ(20, va * vb);
+	TDynamicVector<int> s = va + vb + v;
+	EXPECT_EQ(6, s[3]);
+	va += v;
+	EXPECT_EQ(5, a[3]);
+	TVectorView<int> vv = v;
+	vv *= 2;
+	EXPECT_EQ(2, v[0]);
+}
+
+// v[i] = i, результат сравнивается с ожидаемым массивом
+static void check_elements(const TDynamicVector<int>& v, const int* expected)
+{
+	for (size_t i = 0; i < v.size(); i++)
+		EXPECT_EQ(expected[i], v[i]) << "i = " << i;
+}
+
+TEST(TDynamicVector, overlapping_views_are_read_before_writing)
+{
+	TDynamicVector<int> v(5);
+	auto reset = [&v] { for (size_t i = 0; i < 5; i++) v[i] = int(i); };
+	TVectorView<int> head(v.data(), 4), tail(v.data() + 1, 4);
+
+	reset();
+	tail = head;
+	const int shifted_right[5] = { 0, 0, 1, 2, 3 };
+	check_elements(v, shifted_right);
+	reset();
+	head = tail;
+	const int shifted_left[5] = { 1, 2, 3, 4, 4 };
+	check_elements(v, shifted_left);
+	reset();
+	head = TVectorView<const int>(v.data() + 1, 4) * 2;
+	const int doubled[5] = { 2, 4, 6, 8, 4 };
+	check_elements(v, doubled);
+	reset();
+	tail += head;
+	const int summed[5] = { 0, 1, 3, 5, 7 };
+	check_elements(v, summed);
+	reset();
+	// элементы 2, 4 <- 0, 2 через шаг 2
+	TStridedVectorView<int>(v.data() + 2, 2, 2) = TStridedVectorView<const int>(v.data(), 2, 2);
+	const int strided[5] = { 0, 1, 0, 3, 2 };
+	check_elements(v, strided);
+	reset();
+	// та же память с тем же шагом - поэлементное обновление на месте
+	head += head;
+	const int in_place[5] = { 0, 2, 4, 6, 4 };
+	check_elements(v, in_place);
 }
\ No newline at end of file